@@ -10,8 +10,16 @@
  * the data that was in the persistent heap.
  * If not, we update the array with the new interned value (and free the old
  * one).
+ *
+ * The comparison is skipped when the constants were already checked by a
+ * previous run of the same binary: the binary is identified by a fingerprint
+ * kept in the persistent heap next to the array.
  */
 /*****************************************************************************/
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <link.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -21,8 +29,15 @@
 
 // pconsts = persistent consts (the array is in the persistent heap).
 extern void*** pconsts;
+extern uint64_t* pconsts_fingerprint;
 size_t pconsts_count = 0;
 
+// Set when the constants of pconsts are known to be the ones of this binary.
+static int pconsts_trusted = 0;
+
+// Set when a constant of this binary is not the one in pconsts.
+static int pconsts_changed = 0;
+
 // mconsts = malloced consts (the array is allocated with malloc).
 void** mconsts = NULL;
 size_t mconsts_count = 0;
@@ -38,16 +53,112 @@ void SKIP_unsafe_disable_new_const_mode() {
   unsafe_new_const_mode = 0;
 }
 
+/*****************************************************************************/
+/* Identifies the Skip code of the process. It is not the executable: a Skip
+ * library can be loaded by another program (node for the skipruntime addon).
+ * The object holding SKIP_initializeSkip, which is generated by skc, is the
+ * one identified, by the GNU build-id note the linker computes from its
+ * contents (skc links with --build-id). Returns 0 when the object has no
+ * build-id, in which case the constants are always compared.
+ */
+/*****************************************************************************/
+
+void SKIP_initializeSkip();
+
+static uint64_t sk_fingerprint_mix(uint64_t h, uint64_t value) {
+  for (int i = 0; i < 8; i++) {
+    h ^= (value >> (i * 8)) & 0xFF;
+    h *= 0x100000001B3ULL;
+  }
+  return h;
+}
+
+#if defined(__linux__) && defined(__GLIBC__)
+// Whether the object of info is the one mapping addr.
+static int sk_object_maps(struct dl_phdr_info* info, uintptr_t addr) {
+  for (int i = 0; i < info->dlpi_phnum; i++) {
+    const ElfW(Phdr)* phdr = &info->dlpi_phdr[i];
+    uintptr_t start = info->dlpi_addr + phdr->p_vaddr;
+    if (phdr->p_type == PT_LOAD && addr >= start &&
+        addr < start + phdr->p_memsz) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static uint64_t sk_build_id_fingerprint(struct dl_phdr_info* info) {
+  for (int i = 0; i < info->dlpi_phnum; i++) {
+    const ElfW(Phdr)* phdr = &info->dlpi_phdr[i];
+    if (phdr->p_type != PT_NOTE) {
+      continue;
+    }
+    const char* note = (const char*)(info->dlpi_addr + phdr->p_vaddr);
+    const char* end = note + phdr->p_memsz;
+    // The name and the descriptor of a note are padded to 4 bytes.
+    while (note + sizeof(ElfW(Nhdr)) <= end) {
+      const ElfW(Nhdr)* nhdr = (const ElfW(Nhdr)*)note;
+      const char* name = note + sizeof(ElfW(Nhdr));
+      const unsigned char* desc =
+          (const unsigned char*)(name + ((nhdr->n_namesz + 3) & ~3u));
+      note = (const char*)desc + ((nhdr->n_descsz + 3) & ~3u);
+      if (note > end) {
+        break;
+      }
+      if (nhdr->n_type != NT_GNU_BUILD_ID || nhdr->n_namesz != 4 ||
+          name[0] != 'G' || name[1] != 'N' || name[2] != 'U' ||
+          nhdr->n_descsz == 0) {
+        continue;
+      }
+      uint64_t h = 0xCBF29CE484222325ULL;
+      for (uint32_t j = 0; j < nhdr->n_descsz; j++) {
+        h = sk_fingerprint_mix(h, desc[j]);
+      }
+      return h == 0 ? 1 : h;
+    }
+  }
+  return 0;
+}
+
+static int sk_find_build_id(struct dl_phdr_info* info, size_t size,
+                            void* data) {
+  (void)size;
+  if (!sk_object_maps(info, (uintptr_t)SKIP_initializeSkip)) {
+    return 0;
+  }
+  *(uint64_t*)data = sk_build_id_fingerprint(info);
+  return 1;
+}
+#endif
+
+static uint64_t sk_binary_fingerprint() {
+  static uint64_t fingerprint = 0;
+  static int computed = 0;
+  if (computed) {
+    return fingerprint;
+  }
+  computed = 1;
+#if defined(__linux__) && defined(__GLIBC__)
+  dl_iterate_phdr(sk_find_build_id, &fingerprint);
+#endif
+  return fingerprint;
+}
+
 char* sk_new_const(char* cst) {
   if ((*pconsts) != NULL) {
+    if (pconsts_count == 0) {
+      uint64_t fingerprint = sk_binary_fingerprint();
+      pconsts_trusted = fingerprint != 0 && *pconsts_fingerprint == fingerprint;
+    }
     void* pcst = (*pconsts)[pconsts_count];
-    if (SKIP_isEq(pcst, cst) == 0) {
+    if (pconsts_trusted || SKIP_isEq(pcst, cst) == 0) {
       pconsts_count++;
       return pcst;
     }
 #ifdef SKIP64
     if (!sk_is_nofile_mode()) {
       if (unsafe_new_const_mode) {
+        pconsts_changed = 1;
         return cst;
       }
       fprintf(stderr, "Cannot have a changing constant in persistent mode\n");
@@ -90,15 +201,25 @@ char* sk_new_const(char* cst) {
 /* Called after the consts initialization is over.
  * If it's the first initialization (the persistent heap started from scratch)
  * we copy over the data that was in mconsts into pconsts.
- * Otherwise, we do nothing.
+ * In both cases, pconsts now holds the constants of this binary, which is
+ * recorded for the next runs (unless some constants were not persisted).
  */
 /*****************************************************************************/
 
 void sk_persist_consts() {
-  if ((*pconsts) != NULL) return;
+  uint64_t fingerprint = pconsts_changed ? 0 : sk_binary_fingerprint();
+  if ((*pconsts) != NULL) {
+    if (*pconsts_fingerprint != fingerprint) {
+      sk_global_lock();
+      *pconsts_fingerprint = fingerprint;
+      sk_global_unlock();
+    }
+    return;
+  }
   sk_global_lock();
   *pconsts = (void**)sk_palloc(mconsts_count * sizeof(void*));
   memcpy(*pconsts, mconsts, mconsts_count * sizeof(void*));
   sk_free_size(mconsts, mconsts_size * sizeof(void*));
+  *pconsts_fingerprint = fingerprint;
   sk_global_unlock();
 }
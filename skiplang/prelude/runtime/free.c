@@ -27,9 +27,10 @@ SkipInt SKIP_get_free_test_counter() {
 /*****************************************************************************/
 
 void free_intern(char* obj, size_t memsize, size_t leftsize) {
+  sk_rc_log_forget(obj);
   memsize += leftsize;
-  void* addr = obj - leftsize - sizeof(uintptr_t);
-  sk_pfree_size(addr, memsize + sizeof(uintptr_t));
+  void* addr = obj - leftsize - sk_intern_header_size;
+  sk_pfree_size(addr, memsize + sk_intern_header_size);
 }
 
 void sk_free_obj(sk_stack_t* st, char* obj) {
@@ -111,104 +111,307 @@ static uint64_t sk_crc64(uint64_t crc, const void* p, size_t len) {
   return crc;
 }
 
-static uint64_t sk_crc64_combine(uint64_t crc, void* p) {
-#ifdef SKIP32
-  const unsigned char* _p = (unsigned char*)&p;
-  unsigned int t = ((unsigned int)(crc >> 56) ^ (*_p++)) & 0xFF;
-  crc = crc64table[t] ^ (crc << 8);
-  t = ((unsigned int)(crc >> 56) ^ (*_p++)) & 0xFF;
-  crc = crc64table[t] ^ (crc << 8);
-  t = ((unsigned int)(crc >> 56) ^ (*_p++)) & 0xFF;
-  crc = crc64table[t] ^ (crc << 8);
-  t = ((unsigned int)(crc >> 56) ^ (*_p++)) & 0xFF;
-  crc = crc64table[t] ^ (crc << 8);
-  return crc;
-#endif
-#ifdef SKIP64
-  return sk_crc64(crc, &p, sizeof(void*));
-#endif
-}
-
 SkipInt SKIP_hash_combine(SkipInt crc1, SkipInt crc2) {
   return (SkipInt)sk_crc64((uint64_t)crc1, &crc2, sizeof(SkipInt));
 }
 
 /*****************************************************************************/
-/* Hashing of SKIP objects. */
+/* Hashing of SKIP objects.
+ *
+ * The hash is structural and compositional: every non-null reference of an
+ * object contributes the hash of the object it points to, never its address.
+ * Likewise, the type of an object contributes an id computed from its
+ * layout and name (see sk_type_id), which doesn't depend on where the binary
+ * is loaded. Two equal subgraphs therefore always hash to the same value,
+ * wherever they live (obstack or persistent heap) and whichever process
+ * hashes them, which lets us memoize the hash of interned objects in their
+ * header (see sk_intern_header_size).
+ *
+ * The memos are only written by sk_hash_interned, right after the objects
+ * are interned, under the global lock: the objects are not reachable from
+ * anywhere else yet. SKIP_hash only reads them, so it doesn't write to the
+ * persistent heap, and may run from any thread.
+ *
+ * The traversal is iterative (post-order) to avoid blowing the C stack on
+ * long lists: a node is pushed twice on the stack, once to schedule its
+ * children, once (with HASH_POST as slot) to combine their hashes. The
+ * hashes of the children are accumulated on a separate stack of results.
+ */
 /*****************************************************************************/
 
+#define HASH_POST ((void**)1)
+
+typedef struct {
+  size_t head;
+  size_t capacity;
+  uint64_t* values;
+} sk_hash_stack_t;
+
+static void sk_hash_stack_init(sk_hash_stack_t* st, size_t capacity) {
+  st->head = 0;
+  st->capacity = capacity;
+  st->values = (uint64_t*)sk_malloc(sizeof(uint64_t) * capacity);
+}
+
+static void sk_hash_stack_free(sk_hash_stack_t* st) {
+  sk_free_size(st->values, sizeof(uint64_t) * st->capacity);
+}
+
+static void sk_hash_stack_push(sk_hash_stack_t* st, uint64_t value) {
+  if (st->head >= st->capacity) {
+    size_t new_capacity = st->capacity * 2;
+    uint64_t* new_values =
+        (uint64_t*)sk_malloc(sizeof(uint64_t) * new_capacity);
+    memcpy(new_values, st->values, sizeof(uint64_t) * st->capacity);
+    sk_free_size(st->values, sizeof(uint64_t) * st->capacity);
+    st->values = new_values;
+    st->capacity = new_capacity;
+  }
+  st->values[st->head] = value;
+  st->head++;
+}
+
+static uint64_t sk_hash_stack_pop(sk_hash_stack_t* st) {
+  st->head--;
+  return st->values[st->head];
+}
+
 static uint64_t sk_hash_string(char* obj) {
   uint64_t crc = CRC_INIT;
   size_t size = get_sk_string(obj)->size;  // don't need to hash nul terminator
   return sk_crc64(crc, obj, size);
 }
 
-static uint64_t sk_hash_obj(sk_stack_t* st, char* obj) {
+#ifdef SKIP32
+// In 32bits mode there are no threads (see obstack.c).
+#define __thread
+#endif
+
+#define TYPE_ID_CACHE_SIZE 256
+
+typedef struct {
+  SKIP_gc_type_t* ty;
+  uint64_t id;
+} sk_type_id_cache_t;
+
+static __thread sk_type_id_cache_t type_id_cache[TYPE_ID_CACHE_SIZE];
+
+/* The part of the hash of an object that comes from its type. */
+static uint64_t sk_type_id(SKIP_gc_type_t* ty) {
+  sk_type_id_cache_t* cached =
+      &type_id_cache[((uintptr_t)ty / sizeof(void*)) % TYPE_ID_CACHE_SIZE];
+  if (cached->ty == ty) {
+    return cached->id;
+  }
+  const size_t refMaskWordBitSize = sizeof(ty->m_refMask[0]) * 8;
+  size_t nbr_slots = ty->m_userByteSize / sizeof(void*);
+  // The mask is only there for the types with references.
+  size_t nbr_mask_words =
+      (ty->m_refsHintMask & 1) == 0
+          ? 0
+          : (nbr_slots + refMaskWordBitSize - 1) / refMaskWordBitSize;
+  uint64_t id = sk_crc64(CRC_INIT, &ty->m_kind, sizeof(ty->m_kind));
+  id = sk_crc64(id, &ty->m_userByteSize, sizeof(ty->m_userByteSize));
+  id = sk_crc64(id, ty->m_refMask, sizeof(ty->m_refMask[0]) * nbr_mask_words);
+  if (ty->m_hasName) {
+    char* name = (char*)&ty->m_refMask[nbr_mask_words];
+    size_t len = 0;
+    while (name[len] != 0) {
+      len++;
+    }
+    id = sk_crc64(id, name, len);
+  }
+  cached->ty = ty;
+  cached->id = id;
+  return id;
+}
+
+static uint64_t sk_crc64_combine_type(uint64_t crc, SKIP_gc_type_t* ty) {
+  uint64_t id = sk_type_id(ty);
+  return sk_crc64(crc, &id, sizeof(uint64_t));
+}
+
+/* Returns the address of the memoized hash of an object, or NULL if the
+ * object doesn't have one. Only interned objects carry a hash slot, and we
+ * can only tell them apart from the others on 64 bits.
+ */
+static uint64_t* sk_hash_memo_addr(char* obj) {
+#ifdef SKIP64
+  if (!sk_is_static(obj)) {
+    return sk_get_hash_addr(obj);
+  }
+#endif
+  (void)obj;
+  return NULL;
+}
+
+/* Hashes are memoized as non-zero values, 0 means "not computed yet". The
+ * memo is only written when memoize is set (see sk_hash_interned).
+ */
+static uint64_t sk_hash_memoize(char* obj, uint64_t crc, int memoize) {
+  if (crc == 0) {
+    crc = CRC_INIT;
+  }
+  if (memoize) {
+    uint64_t* memo = sk_hash_memo_addr(obj);
+    if (memo != NULL) {
+      *memo = crc;
+    }
+  }
+  return crc;
+}
+
+/* Schedules the hashing of an object. Leaves and objects with a memoized
+ * hash are resolved immediately, the others are expanded.
+ */
+static void sk_hash_pre(sk_stack_t* st, sk_hash_stack_t* results, char* obj,
+                        int memoize) {
   if (obj < (char*)64) {
-    return (uint64_t)obj;
+    sk_hash_stack_push(results, (uint64_t)obj);
+    return;
+  }
+
+  uint64_t* memo = sk_hash_memo_addr(obj);
+  if (memo != NULL && *memo != 0) {
+    sk_hash_stack_push(results, *memo);
+    return;
   }
 
   // Check if we are dealing with a string
   if (SKIP_is_string(obj)) {
-    return sk_hash_string(obj);
+    uint64_t crc = sk_hash_string(obj);
+    sk_hash_stack_push(results, sk_hash_memoize(obj, crc, memoize));
+    return;
   }
 
-  uint64_t crc = CRC_INIT;
   SKIP_gc_type_t* ty = get_gc_type(obj);
 
+  if ((ty->m_refsHintMask & 1) == 0) {
+    size_t len = skip_object_len(ty, obj);
+    size_t memsize = ty->m_userByteSize * len;
+    uint64_t crc = sk_crc64(CRC_INIT, obj, memsize);
+    crc = sk_crc64_combine_type(crc, ty);
+    sk_hash_stack_push(results, sk_hash_memoize(obj, crc, memoize));
+    return;
+  }
+
+  sk_stack_push(st, (void**)obj, HASH_POST);
+
+  const size_t refMaskWordBitSize = sizeof(ty->m_refMask[0]) * 8;
   size_t len = skip_object_len(ty, obj);
-  size_t memsize = ty->m_userByteSize * len;
+  char* ohead = obj;
+  char* end = obj + ty->m_userByteSize * len;
 
-  if ((ty->m_refsHintMask & 1) == 0) {
-    crc = sk_crc64(crc, obj, memsize);
-  } else {
-    const size_t refMaskWordBitSize = sizeof(ty->m_refMask[0]) * 8;
-    char* ohead = obj;
-    char* end = obj + memsize;
-
-    while (ohead < end) {
-      size_t size = ty->m_userByteSize;
-      size_t mask_slot = 0;
-      while (size > 0) {
-        unsigned int i;
-        for (i = 0; i < refMaskWordBitSize && size > 0; i++) {
-          if (ty->m_refMask[mask_slot] & (1 << i)) {
-            void** ptr = (void**)ohead;
-            if (*ptr != NULL) {
-              sk_stack_push(st, ptr, ptr);
-            }
-          } else {
-            crc = sk_crc64(crc, ohead, sizeof(void*));
+  while (ohead < end) {
+    size_t size = ty->m_userByteSize;
+    size_t mask_slot = 0;
+    while (size > 0) {
+      unsigned int i;
+      for (i = 0; i < refMaskWordBitSize && size > 0; i++) {
+        if (ty->m_refMask[mask_slot] & (1 << i)) {
+          void** ptr = *(void***)ohead;
+          if (ptr != NULL) {
+            sk_stack_push(st, ptr, NULL);
           }
-          ohead += sizeof(void*);
-          size -= sizeof(void*);
         }
-        mask_slot++;
+        ohead += sizeof(void*);
+        size -= sizeof(void*);
       }
+      mask_slot++;
     }
   }
+}
 
-  crc = sk_crc64_combine(crc, ty);
+/* Combines the hashes of the children of an object (found on top of the
+ * results stack, the first field on top) with its scalar fields.
+ */
+static void sk_hash_post(sk_hash_stack_t* results, char* obj, int memoize) {
+  SKIP_gc_type_t* ty = get_gc_type(obj);
+  const size_t refMaskWordBitSize = sizeof(ty->m_refMask[0]) * 8;
+  size_t len = skip_object_len(ty, obj);
+  char* ohead = obj;
+  char* end = obj + ty->m_userByteSize * len;
+  uint64_t crc = CRC_INIT;
 
-  return crc;
+  while (ohead < end) {
+    size_t size = ty->m_userByteSize;
+    size_t mask_slot = 0;
+    while (size > 0) {
+      unsigned int i;
+      for (i = 0; i < refMaskWordBitSize && size > 0; i++) {
+        if ((ty->m_refMask[mask_slot] & (1 << i)) && *(void**)ohead != NULL) {
+          uint64_t child = sk_hash_stack_pop(results);
+          crc = sk_crc64(crc, &child, sizeof(uint64_t));
+        } else {
+          crc = sk_crc64(crc, ohead, sizeof(void*));
+        }
+        ohead += sizeof(void*);
+        size -= sizeof(void*);
+      }
+      mask_slot++;
+    }
+  }
+
+  crc = sk_crc64_combine_type(crc, ty);
+  sk_hash_stack_push(results, sk_hash_memoize(obj, crc, memoize));
 }
 
-uint64_t SKIP_hash(void* obj) {
+static uint64_t sk_hash(void* obj, int memoize) {
   sk_stack_t st_holder;
   sk_stack_t* st = &st_holder;
-  uint64_t crc = CRC_INIT;
+  sk_hash_stack_t results_holder;
+  sk_hash_stack_t* results = &results_holder;
 
   sk_stack_init(st, STACK_INIT_CAPACITY);
-  sk_stack_push(st, &obj, 0);
+  sk_hash_stack_init(results, STACK_INIT_CAPACITY);
+  sk_stack_push(st, obj, NULL);
 
   while (st->head > 0) {
     sk_value_t delayed = sk_stack_pop(st);
-    void* toHash = *delayed.value;
-    uint64_t new_crc = sk_hash_obj(st, toHash);
-    crc = sk_crc64(crc, &new_crc, sizeof(uint64_t));
+    char* toHash = (char*)delayed.value;
+    if (delayed.slot == HASH_POST) {
+      sk_hash_post(results, toHash, memoize);
+    } else {
+      sk_hash_pre(st, results, toHash, memoize);
+    }
   }
 
+  uint64_t crc = sk_hash_stack_pop(results);
+
+  sk_hash_stack_free(results);
   sk_stack_free(st);
 
   return crc;
 }
+
+uint64_t SKIP_hash(void* obj) {
+  return sk_hash(obj, 0);
+}
+
+/* Memoizes the hash of an object that was just interned, and of the objects
+ * it points to that were interned with it. Must be called with the global
+ * lock held. There is nowhere to memoize it on 32 bits.
+ */
+void sk_hash_interned(void* obj) {
+#ifdef SKIP64
+  if (obj != NULL) {
+    (void)sk_hash(obj, 1);
+  }
+#endif
+  (void)obj;
+}
+
+/* Returns 1 when both objects carry a memoized hash and the hashes differ,
+ * in which case the objects are known to be structurally different.
+ */
+int sk_hash_memo_differs(char* obj1, char* obj2) {
+  uint64_t* memo1 = sk_hash_memo_addr(obj1);
+  if (memo1 == NULL || *memo1 == 0) {
+    return 0;
+  }
+  uint64_t* memo2 = sk_hash_memo_addr(obj2);
+  if (memo2 == NULL || *memo2 == 0) {
+    return 0;
+  }
+  return *memo1 != *memo2;
+}
@@ -53,8 +53,12 @@ int32_t sk_pop_dirty_page() {
 
 static char* shallow_intern(char* obj, size_t memsize, size_t leftsize) {
   memsize += leftsize;
-  size_t alloc_size = memsize + sizeof(uintptr_t);
+  size_t alloc_size = memsize + sk_intern_header_size;
   char* mem = sk_palloc(alloc_size);
+#ifdef SKIP64
+  *(uint64_t*)mem = 0;
+  mem += sizeof(uint64_t);
+#endif
   *(uintptr_t*)mem = 1;
   mem += sizeof(uintptr_t);
   memcpy(mem, obj - leftsize, memsize);
@@ -82,7 +86,110 @@ static uintptr_t* sk_get_ref_count_addr(void* obj) {
   return count;
 }
 
+/*****************************************************************************/
+/* Deferred reference counting.
+ *
+ * A commit increments the reference count of every persistent object shared
+ * by the new root and the previous one (see SKIP_intern_shared), and then
+ * decrements most of them right away when the previous root is released (see
+ * sk_free_root). While a log is open, reference count updates are coalesced
+ * in a table instead of being written to the objects, and only the net deltas
+ * are written back when the log is flushed. Objects shared by both versions
+ * (the vast majority of them) are then never written to, which spares us
+ * from dirtying (and msync-ing) cold pages of the persistent heap.
+ *
+ * Deltas are stored doubled, so that they are always even and never collide
+ * with TOMB.
+ */
+/*****************************************************************************/
+
+static sk_htbl_t sk_rc_log;
+// The number of times the log was opened and not closed yet: a commit can
+// run inside another one (e.g. through a nested sync), the deltas are only
+// written back when the outermost one closes the log.
+static int sk_rc_log_depth = 0;
+
+// Objects are word-aligned, and sk_htbl_t uses the low bits of the keys to
+// spread them over the table.
+static void* sk_rc_log_key(void* obj) {
+  return (void*)((uintptr_t)obj / sizeof(void*));
+}
+
+static int64_t sk_rc_log_get(void* obj) {
+  sk_cell_t* cell = sk_htbl_find(&sk_rc_log, sk_rc_log_key(obj));
+  if (cell == NULL) {
+    return 0;
+  }
+  return (int64_t)cell->value / 2;
+}
+
+static int64_t sk_rc_log_add(void* obj, int64_t delta) {
+  void* key = sk_rc_log_key(obj);
+  sk_cell_t* cell = sk_htbl_find(&sk_rc_log, key);
+  if (cell == NULL) {
+    sk_htbl_add(&sk_rc_log, key, (uint64_t)(delta * 2));
+    return delta;
+  }
+  delta += (int64_t)cell->value / 2;
+  cell->value = (uint64_t)(delta * 2);
+  return delta;
+}
+
+static void sk_rc_log_apply() {
+  size_t capacity = 1 << sk_rc_log.bitcapacity;
+  size_t i;
+
+  for (i = 0; i < capacity; i++) {
+    sk_cell_t* cell = &sk_rc_log.data[i];
+    if (cell->key == 0 || cell->value == TOMB || cell->value == 0) {
+      continue;
+    }
+    void* obj = (void*)((uintptr_t)cell->key * sizeof(void*));
+#ifdef SKIP32
+    sk_persistent_write(obj, 0);
+#endif
+    uintptr_t* count = sk_get_ref_count_addr(obj);
+    *count = (uintptr_t)((int64_t)*count + (int64_t)cell->value / 2);
+  }
+}
+
+void sk_rc_log_open() {
+  if (sk_rc_log_depth++ > 0) {
+    return;
+  }
+  sk_htbl_init(&sk_rc_log, 10);
+}
+
+// Writes the pending deltas back, the log stays open.
+void sk_rc_log_flush() {
+  if (sk_rc_log_depth == 0) {
+    return;
+  }
+  sk_rc_log_apply();
+  sk_htbl_free(&sk_rc_log);
+  sk_htbl_init(&sk_rc_log, 10);
+}
+
+void sk_rc_log_close() {
+  if (sk_rc_log_depth == 0 || --sk_rc_log_depth > 0) {
+    return;
+  }
+  sk_rc_log_apply();
+  sk_htbl_free(&sk_rc_log);
+}
+
+// Must be called when an object is freed: its address can be reused.
+void sk_rc_log_forget(void* obj) {
+  if (sk_rc_log_depth > 0) {
+    sk_htbl_remove(&sk_rc_log, sk_rc_log_key(obj));
+  }
+}
+
 void sk_incr_ref_count(void* obj) {
+  if (sk_rc_log_depth > 0) {
+    sk_rc_log_add(obj, 1);
+    return;
+  }
 #ifdef SKIP32
   sk_persistent_write(obj, 0);
 #endif
@@ -91,6 +198,11 @@ void sk_incr_ref_count(void* obj) {
 }
 
 uintptr_t sk_decr_ref_count(void* obj) {
+  if (sk_rc_log_depth > 0) {
+    int64_t delta = sk_rc_log_add(obj, -1);
+    uintptr_t* count = sk_get_ref_count_addr(obj);
+    return (uintptr_t)((int64_t)*count + delta);
+  }
 #ifdef SKIP32
   sk_persistent_write(obj, 0);
 #endif
@@ -101,9 +213,18 @@ uintptr_t sk_decr_ref_count(void* obj) {
 
 uintptr_t sk_get_ref_count(void* obj) {
   uintptr_t* count = sk_get_ref_count_addr(obj);
+  if (sk_rc_log_depth > 0) {
+    return (uintptr_t)((int64_t)*count + sk_rc_log_get(obj));
+  }
   return *count;
 }
 
+#ifdef SKIP64
+uint64_t* sk_get_hash_addr(void* obj) {
+  return (uint64_t*)sk_get_ref_count_addr(obj) - 1;
+}
+#endif
+
 static char* SKIP_intern_obj(sk_stack_t* st, char* obj) {
   SKIP_gc_type_t* ty = get_gc_type(obj);
 
@@ -238,6 +359,8 @@ void* SKIP_intern_shared(void* obj) {
   sk_stack_free(st);
   sk_stack3_free(st3);
 
+  sk_hash_interned(result);
+
   return result;
 }
 
@@ -245,6 +368,40 @@ void* SKIP_intern(void* obj) {
   return sk_new_const(obj);
 }
 
+/*****************************************************************************/
+/* Primitives used to test interning and the reference counts. */
+/*****************************************************************************/
+
+void* SKIP_test_intern(void* obj) {
+  sk_global_lock();
+  void* result = SKIP_intern_shared(obj);
+  sk_global_unlock();
+  return result;
+}
+
+void SKIP_test_free(void* obj) {
+  sk_global_lock();
+  sk_free_root(obj);
+  sk_global_unlock();
+}
+
+// The count written in the object, without the deltas of an open log.
+SkipInt SKIP_test_ref_count(void* obj) {
+  return (SkipInt)*sk_get_ref_count_addr(obj);
+}
+
+void SKIP_test_rc_log_open() {
+  sk_global_lock();
+  sk_rc_log_open();
+  sk_global_unlock();
+}
+
+void SKIP_test_rc_log_close() {
+  sk_global_lock();
+  sk_rc_log_close();
+  sk_global_unlock();
+}
+
 sk_list_t* sk_external_pointers = NULL;
 
 void* SKIP_create_external_pointer(void* obj) {
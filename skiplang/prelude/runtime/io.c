@@ -0,0 +1,441 @@
+/*****************************************************************************/
+/* File dealing with batched writes to files.
+ *
+ * The appends are queued per file, and written with a single system call per
+ * file when the queue is flushed: a notifier interleaving the appends to
+ * thousands of subscriber files still opens each of them at most once per
+ * flush.
+ *
+ * The files that are written over and over (subscriptions, notifications)
+ * are also kept open, instead of being opened and closed for every write.
+ * The number of open files grows with the number of files written, up to
+ * half of the limit on file descriptors of the process.
+ *
+ * A file that was removed while it was open is reopened (and thus recreated)
+ * the next time it is used. Whatever is still queued at exit is flushed.
+ *
+ * sk_io_mutex only protects the table and the queues: the calls that may
+ * block (open, write, poll) are made while holding the lock of the file
+ * alone, so that a slow file does not hold up the writers of the others.
+ * The lock of a file is always taken before sk_io_mutex.
+ */
+/*****************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "runtime.h"
+
+#define SK_IO_MIN_OPEN_FILES 64
+#define SK_IO_INITIAL_BUCKETS 256
+#define SK_IO_APPEND_FLAGS (O_WRONLY | O_CREAT | O_APPEND)
+#define SK_IO_APPEND_MODE 0777
+
+typedef struct sk_io_file {
+  // Next file in the same bucket.
+  struct sk_io_file* next;
+  uint64_t hash;
+  char* path;
+  int flags;
+  int mode;
+  // Only used by the thread holding lock. -1 when the file is not open.
+  int fd;
+  // The number of threads that hold, or wait for, lock. A file in use is
+  // neither closed by another thread nor removed from the table.
+  int users;
+  pthread_mutex_t lock;
+  char* pending;
+  size_t pending_size;
+  size_t pending_capacity;
+} sk_io_file_t;
+
+static sk_io_file_t** sk_io_buckets = NULL;
+static size_t sk_io_bucket_count = 0;
+static size_t sk_io_file_count = 0;
+static size_t sk_io_open_count = 0;
+static size_t sk_io_max_open = SK_IO_MIN_OPEN_FILES;
+// Where the search for a file to close resumes.
+static size_t sk_io_victim = 0;
+static pthread_mutex_t sk_io_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t sk_io_once = PTHREAD_ONCE_INIT;
+
+static int sk_io_flush_all(void);
+
+/*****************************************************************************/
+/* Writes that are not interrupted by partial writes. */
+/*****************************************************************************/
+
+// Returns 0 or -errno.
+int sk_io_write_all(int fd, const char* buf, size_t size) {
+  while (size > 0) {
+    ssize_t written = write(fd, buf, size);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        struct pollfd pfd = {fd, POLLOUT, 0};
+        if (poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+          return -errno;
+        }
+        continue;
+      }
+      return -errno;
+    }
+    buf += written;
+    size -= (size_t)written;
+  }
+  return 0;
+}
+
+// Same as sk_io_write_all, at the given offset.
+int sk_io_pwrite_all(int fd, const char* buf, size_t size, off_t offset) {
+  while (size > 0) {
+    ssize_t written = pwrite(fd, buf, size, offset);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return -errno;
+    }
+    buf += written;
+    size -= (size_t)written;
+    offset += written;
+  }
+  return 0;
+}
+
+/*****************************************************************************/
+/* The table of files. */
+/*****************************************************************************/
+
+static void* sk_io_alloc(void* ptr, size_t size) {
+  void* result = realloc(ptr, size);
+  if (result == NULL) {
+    perror("realloc");
+    exit(ERROR_OUT_OF_MEMORY);
+  }
+  return result;
+}
+
+static uint64_t sk_io_hash(const char* path, int flags) {
+  uint64_t hash = 14695981039346656037ULL ^ (uint64_t)(unsigned)flags;
+  for (const char* c = path; *c != 0; c++) {
+    hash = (hash ^ (uint64_t)(unsigned char)*c) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+static void sk_io_flush_at_exit(void) {
+  (void)sk_io_flush_all();
+}
+
+static void sk_io_init(void) {
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 &&
+      limit.rlim_cur != RLIM_INFINITY &&
+      limit.rlim_cur / 2 > SK_IO_MIN_OPEN_FILES) {
+    sk_io_max_open = (size_t)(limit.rlim_cur / 2);
+  }
+  sk_io_bucket_count = SK_IO_INITIAL_BUCKETS;
+  sk_io_buckets = sk_io_alloc(NULL, sk_io_bucket_count * sizeof(void*));
+  memset(sk_io_buckets, 0, sk_io_bucket_count * sizeof(void*));
+  atexit(sk_io_flush_at_exit);
+}
+
+static void sk_io_grow(void) {
+  size_t count = sk_io_bucket_count * 2;
+  sk_io_file_t** buckets = sk_io_alloc(NULL, count * sizeof(void*));
+  memset(buckets, 0, count * sizeof(void*));
+  for (size_t i = 0; i < sk_io_bucket_count; i++) {
+    sk_io_file_t* file = sk_io_buckets[i];
+    while (file != NULL) {
+      sk_io_file_t* next = file->next;
+      file->next = buckets[file->hash % count];
+      buckets[file->hash % count] = file;
+      file = next;
+    }
+  }
+  free(sk_io_buckets);
+  sk_io_buckets = buckets;
+  sk_io_bucket_count = count;
+}
+
+// Must be called with sk_io_mutex held. The file is created in the table
+// (but not opened) when it is not there yet.
+static sk_io_file_t* sk_io_get_file(const char* path, int flags, int mode) {
+  pthread_once(&sk_io_once, sk_io_init);
+  uint64_t hash = sk_io_hash(path, flags);
+  sk_io_file_t* file = sk_io_buckets[hash % sk_io_bucket_count];
+  for (; file != NULL; file = file->next) {
+    if (file->hash == hash && file->flags == flags &&
+        strcmp(file->path, path) == 0) {
+      return file;
+    }
+  }
+  if (sk_io_file_count >= sk_io_bucket_count) {
+    sk_io_grow();
+  }
+  file = sk_io_alloc(NULL, sizeof(sk_io_file_t));
+  memset(file, 0, sizeof(sk_io_file_t));
+  size_t len = strlen(path);
+  file->path = sk_io_alloc(NULL, len + 1);
+  memcpy(file->path, path, len + 1);
+  file->hash = hash;
+  file->flags = flags;
+  file->mode = mode;
+  file->fd = -1;
+  pthread_mutex_init(&file->lock, NULL);
+  file->next = sk_io_buckets[hash % sk_io_bucket_count];
+  sk_io_buckets[hash % sk_io_bucket_count] = file;
+  sk_io_file_count++;
+  return file;
+}
+
+// Must be called with sk_io_mutex held. Removes the file from the table when
+// it is neither open, in use nor has queued writes, so that the table does
+// not keep every file ever written.
+static void sk_io_forget(sk_io_file_t* file) {
+  if (file->fd != -1 || file->users != 0 || file->pending_size != 0) {
+    return;
+  }
+  sk_io_file_t** link = &sk_io_buckets[file->hash % sk_io_bucket_count];
+  while (*link != file) {
+    link = &(*link)->next;
+  }
+  *link = file->next;
+  pthread_mutex_destroy(&file->lock);
+  free(file->path);
+  free(file->pending);
+  free(file);
+  sk_io_file_count--;
+}
+
+// Returns the file with its lock held.
+static sk_io_file_t* sk_io_acquire(const char* path, int flags, int mode) {
+  pthread_mutex_lock(&sk_io_mutex);
+  sk_io_file_t* file = sk_io_get_file(path, flags, mode);
+  file->users++;
+  pthread_mutex_unlock(&sk_io_mutex);
+  pthread_mutex_lock(&file->lock);
+  return file;
+}
+
+static void sk_io_release(sk_io_file_t* file) {
+  pthread_mutex_unlock(&file->lock);
+  pthread_mutex_lock(&sk_io_mutex);
+  file->users--;
+  sk_io_forget(file);
+  pthread_mutex_unlock(&sk_io_mutex);
+}
+
+/*****************************************************************************/
+/* The open files. */
+/*****************************************************************************/
+
+// Must be called with sk_io_mutex held, by the thread that holds the lock of
+// the file or when the file is not in use.
+static void sk_io_close(sk_io_file_t* file) {
+  if (file->fd == -1) {
+    return;
+  }
+  close(file->fd);
+  file->fd = -1;
+  sk_io_open_count--;
+}
+
+static int sk_io_is_removed(int fd) {
+  struct stat s;
+  return fstat(fd, &s) == -1 || s.st_nlink == 0;
+}
+
+// Must be called with sk_io_mutex held. Closes an open file that is not in
+// use, preferably one without queued writes, which is then forgotten. The
+// queued writes of the closed file stay queued.
+static void sk_io_close_one(void) {
+  sk_io_file_t* fallback = NULL;
+  for (size_t n = 0; n < sk_io_bucket_count; n++) {
+    size_t i = (sk_io_victim + n) % sk_io_bucket_count;
+    for (sk_io_file_t* file = sk_io_buckets[i]; file != NULL;
+         file = file->next) {
+      if (file->users != 0 || file->fd == -1) continue;
+      if (file->pending_size == 0) {
+        sk_io_victim = i + 1;
+        sk_io_close(file);
+        sk_io_forget(file);
+        return;
+      }
+      if (fallback == NULL) fallback = file;
+    }
+  }
+  if (fallback != NULL) {
+    sk_io_close(fallback);
+  }
+}
+
+// Must be called with the lock of the file held. Returns 0 or -errno.
+static int sk_io_open(sk_io_file_t* file) {
+  if (file->fd != -1) {
+    if (!sk_io_is_removed(file->fd)) {
+      return 0;
+    }
+    pthread_mutex_lock(&sk_io_mutex);
+    sk_io_close(file);
+    pthread_mutex_unlock(&sk_io_mutex);
+  }
+  int fd = open(file->path, file->flags | O_CLOEXEC, file->mode);
+  if (fd == -1) {
+    return -errno;
+  }
+  pthread_mutex_lock(&sk_io_mutex);
+  file->fd = fd;
+  sk_io_open_count++;
+  if (sk_io_open_count > sk_io_max_open) {
+    sk_io_close_one();
+  }
+  pthread_mutex_unlock(&sk_io_mutex);
+  return 0;
+}
+
+// Must be called with the lock of the file held. Returns 0 or -errno.
+static int sk_io_write_file(sk_io_file_t* file, const char* buf, size_t size,
+                            int64_t offset) {
+  int rv = sk_io_open(file);
+  if (rv == 0) {
+    rv = offset == -1 ? sk_io_write_all(file->fd, buf, size)
+                      : sk_io_pwrite_all(file->fd, buf, size, (off_t)offset);
+  }
+  if (rv != 0) {
+    pthread_mutex_lock(&sk_io_mutex);
+    sk_io_close(file);
+    pthread_mutex_unlock(&sk_io_mutex);
+  }
+  return rv;
+}
+
+// Must be called with the lock of the file held. The queued writes are taken
+// out of the queue (under sk_io_mutex, as SKIP_io_append may be adding to
+// it), and written without holding sk_io_mutex. They are dropped when the
+// write fails. Returns 0 or -errno.
+static int sk_io_flush_file(sk_io_file_t* file) {
+  pthread_mutex_lock(&sk_io_mutex);
+  char* pending = file->pending;
+  size_t pending_size = file->pending_size;
+  size_t pending_capacity = file->pending_capacity;
+  file->pending = NULL;
+  file->pending_size = 0;
+  file->pending_capacity = 0;
+  pthread_mutex_unlock(&sk_io_mutex);
+  if (pending_size == 0) {
+    free(pending);
+    return 0;
+  }
+  int rv = sk_io_write_file(file, pending, pending_size, -1);
+  // The buffer is given back to the queue when nothing was queued meanwhile.
+  pthread_mutex_lock(&sk_io_mutex);
+  if (file->pending == NULL) {
+    file->pending = pending;
+    file->pending_capacity = pending_capacity;
+    pending = NULL;
+  }
+  pthread_mutex_unlock(&sk_io_mutex);
+  free(pending);
+  return rv;
+}
+
+// Must be called with sk_io_mutex held.
+static void sk_io_queue(sk_io_file_t* file, const char* buf, size_t size) {
+  size_t needed = file->pending_size + size;
+  if (needed > file->pending_capacity) {
+    size_t capacity = file->pending_capacity;
+    if (capacity == 0) capacity = 4096;
+    while (capacity < needed) capacity *= 2;
+    file->pending = sk_io_alloc(file->pending, capacity);
+    file->pending_capacity = capacity;
+  }
+  memcpy(file->pending + file->pending_size, buf, size);
+  file->pending_size = needed;
+}
+
+/*****************************************************************************/
+/* Entry points. */
+/*****************************************************************************/
+
+// Appends str to filename, without flushing. The file is only opened when the
+// queue is flushed. Returns 0 or -errno.
+int64_t SKIP_io_append(char* filename, char* str) {
+  sk_string_check_c_safe(filename);
+  pthread_mutex_lock(&sk_io_mutex);
+  sk_io_file_t* file =
+      sk_io_get_file(filename, SK_IO_APPEND_FLAGS, SK_IO_APPEND_MODE);
+  sk_io_queue(file, str, SKIP_String_byteSize(str));
+  pthread_mutex_unlock(&sk_io_mutex);
+  return 0;
+}
+
+// Writes what was queued for filename, with a single write. Returns 0 or
+// -errno.
+int64_t SKIP_io_flush_file(char* filename) {
+  sk_string_check_c_safe(filename);
+  sk_io_file_t* file =
+      sk_io_acquire(filename, SK_IO_APPEND_FLAGS, SK_IO_APPEND_MODE);
+  int rv = sk_io_flush_file(file);
+  sk_io_release(file);
+  return rv;
+}
+
+// Writes everything that was queued, with one write per file. Returns 0 or
+// the first -errno.
+static int sk_io_flush_all(void) {
+  int result = 0;
+  pthread_mutex_lock(&sk_io_mutex);
+  size_t count = 0;
+  for (size_t i = 0; i < sk_io_bucket_count; i++) {
+    for (sk_io_file_t* file = sk_io_buckets[i]; file != NULL;
+         file = file->next) {
+      if (file->pending_size != 0) count++;
+    }
+  }
+  sk_io_file_t** files =
+      count == 0 ? NULL : sk_io_alloc(NULL, count * sizeof(void*));
+  size_t n = 0;
+  for (size_t i = 0; i < sk_io_bucket_count; i++) {
+    for (sk_io_file_t* file = sk_io_buckets[i]; file != NULL;
+         file = file->next) {
+      if (file->pending_size != 0) {
+        file->users++;
+        files[n++] = file;
+      }
+    }
+  }
+  pthread_mutex_unlock(&sk_io_mutex);
+  for (size_t i = 0; i < count; i++) {
+    pthread_mutex_lock(&files[i]->lock);
+    int rv = sk_io_flush_file(files[i]);
+    if (rv != 0 && result == 0) {
+      result = rv;
+    }
+    sk_io_release(files[i]);
+  }
+  free(files);
+  return result;
+}
+
+// Writes buf to path opened with flags, after the writes queued for path. The
+// write is done at offset, or at the end of the file when offset is -1.
+// Returns 0 or -errno.
+int sk_io_write_cached(const char* path, int flags, int mode, const char* buf,
+                       size_t size, int64_t offset) {
+  sk_io_file_t* file = sk_io_acquire(path, flags, mode);
+  int rv = sk_io_flush_file(file);
+  if (rv == 0) {
+    rv = sk_io_write_file(file, buf, size, offset);
+  }
+  sk_io_release(file);
+  return rv;
+}
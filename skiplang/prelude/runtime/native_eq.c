@@ -92,6 +92,11 @@ SkipInt SKIP_native_eq_helper(sk_stack_t* st, char* obj1, char* obj2) {
     return 1;
   }
 
+  // Two interned objects whose memoized hashes differ cannot be equal.
+  if (sk_hash_memo_differs(obj1, obj2)) {
+    return 1;
+  }
+
   uint32_t isString1 = SKIP_is_string(obj1);
   uint32_t isString2 = SKIP_is_string(obj2);
 
@@ -283,6 +283,28 @@ void* SKIP_destroy_Obstack_with_value(sk_saved_obstack_t* saved, void* toCopy) {
   return result;
 }
 
+// Destroys an obstack whose values were copied elsewhere with
+// SKIP_copy_with_pages, using the same page table. Large pages that were
+// moved to the destination obstack during the copy are left alone.
+void sk_destroy_Obstack_with_pages(sk_saved_obstack_t* saved, size_t nbr_pages,
+                                   sk_cell_t* pages) {
+  page = saved->page;
+  head = saved->head;
+  end = saved->end;
+
+  saved->page = NULL;
+  saved->head = NULL;
+  saved->end = NULL;
+
+  unsigned int i;
+  for (i = 0; i < nbr_pages; i++) {
+    if ((uint64_t)pages[i].key != pages[i].value) {
+      sk_obstack_t* fpage = (sk_obstack_t*)(pages[i].key);
+      sk_free_page(fpage);
+    }
+  }
+}
+
 sk_obstack_t* SKIP_switch_to_parent(sk_saved_obstack_t* saved) {
   // Gather current obstack data
   sk_obstack_t* first = page;
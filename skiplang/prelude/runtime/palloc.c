@@ -11,7 +11,7 @@
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
-#include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "runtime.h"
@@ -26,6 +26,9 @@
 
 void*** pconsts = NULL;
 
+// Identifies the binary that last initialized pconsts, 0 if unknown.
+uint64_t* pconsts_fingerprint = NULL;
+
 /*****************************************************************************/
 /* Database capacity. */
 /*****************************************************************************/
@@ -76,8 +79,72 @@ ginfo_t* ginfo = NULL;
 pthread_mutexattr_t* gmutex_attr;
 pthread_mutex_t* gmutex = (void*)1234;
 
-// This is only used for debugging purposes
-int sk_is_locked = 0;
+// This is only used for debugging purposes. It is per thread, a thread
+// doesn't hold the lock because another one does.
+__thread int sk_is_locked = 0;
+
+// Without a file, the threads of the process are serialized by this mutex
+// instead of the one in the mapping, so that a host can drive the runtime
+// from several threads, one at a time: they still share the same roots, and
+// thus the same contexts. It is recursive because the lock used to be a
+// no-op in that mode, the code running without a file may take it twice.
+static pthread_mutex_t sk_no_file_mutex;
+static pthread_once_t sk_no_file_mutex_once = PTHREAD_ONCE_INIT;
+
+// A Parallel.tabulate job started by a thread holding the global lock runs
+// on behalf of that thread: the threads of the job (the caller included)
+// share its ownership of the lock. Taking the global lock from one of them
+// takes sk_shared_mutex instead, which serializes them with each other while
+// the global lock stays held by the caller. Until the job is over, the
+// caller no longer counts as holding the lock, so that the persistent heap is
+// only reached through the entry points that take it.
+__thread int sk_lock_shared = 0;
+static pthread_mutex_t sk_shared_mutex;
+static pthread_once_t sk_shared_mutex_once = PTHREAD_ONCE_INIT;
+
+static void sk_recursive_mutex_init(pthread_mutex_t* mutex) {
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(mutex, &attr);
+  pthread_mutexattr_destroy(&attr);
+}
+
+static void sk_no_file_mutex_init() {
+  sk_recursive_mutex_init(&sk_no_file_mutex);
+}
+
+static void sk_shared_mutex_init() {
+  sk_recursive_mutex_init(&sk_shared_mutex);
+}
+
+// Called by the thread starting a Parallel.tabulate job. Returns whether
+// the job shares the global lock, to give to the threads of the job with
+// sk_global_lock_join, and then back to sk_global_lock_unshare.
+int sk_global_lock_share() {
+  if (sk_is_locked == 0) {
+    return 0;
+  }
+  pthread_once(&sk_shared_mutex_once, sk_shared_mutex_init);
+  int saved = sk_is_locked;
+  sk_is_locked = 0;
+  sk_lock_shared = 1;
+  return saved;
+}
+
+// Called by the other threads of the job, with the result of
+// sk_global_lock_share when they start on it, and with 0 when they are done.
+void sk_global_lock_join(int shared) {
+  sk_lock_shared = shared != 0;
+}
+
+void sk_global_lock_unshare(int shared) {
+  if (shared == 0) {
+    return;
+  }
+  sk_lock_shared = 0;
+  sk_is_locked = shared;
+}
 
 void sk_check_has_lock() {
   if ((ginfo->fileName != NULL) && !sk_is_locked) {
@@ -96,7 +163,22 @@ void sk_global_lock_init() {
 }
 
 void sk_global_lock() {
+  if (sk_lock_shared) {
+    if (pthread_mutex_lock(&sk_shared_mutex) != 0) {
+      perror("Internal error: locking failed");
+      exit(ERROR_LOCKING);
+    }
+    sk_is_locked++;
+    return;
+  }
+
   if (ginfo->fileName == NULL) {
+    pthread_once(&sk_no_file_mutex_once, sk_no_file_mutex_init);
+    if (pthread_mutex_lock(&sk_no_file_mutex) != 0) {
+      perror("Internal error: locking failed");
+      exit(ERROR_LOCKING);
+    }
+    sk_is_locked++;
     return;
   }
 
@@ -119,7 +201,21 @@ void sk_global_lock() {
 }
 
 void sk_global_unlock() {
+  if (sk_lock_shared) {
+    sk_is_locked--;
+    if (pthread_mutex_unlock(&sk_shared_mutex) != 0) {
+      perror("Internal error: global unlocking failed");
+      exit(ERROR_LOCKING);
+    }
+    return;
+  }
+
   if (ginfo->fileName == NULL) {
+    sk_is_locked--;
+    if (pthread_mutex_unlock(&sk_no_file_mutex) != 0) {
+      perror("Internal error: global unlocking failed");
+      exit(ERROR_LOCKING);
+    }
     return;
   }
 
@@ -212,16 +308,24 @@ void SKIP_cond_wait(pthread_cond_t* x, pthread_mutex_t* y) {
   pthread_cond_wait(x, y);
 }
 
-int32_t SKIP_cond_timedwait(pthread_cond_t* x, pthread_mutex_t* y,
-                            uint32_t secs) {
-  struct timeval tv;
+int32_t SKIP_cond_timedwait_ms(pthread_cond_t* x, pthread_mutex_t* y,
+                               int64_t ms) {
   struct timespec ts;
-  gettimeofday(&tv, NULL);
-  ts.tv_sec = tv.tv_sec + secs;
-  ts.tv_nsec = 0;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_sec += ms / 1000;
+  ts.tv_nsec += (ms % 1000) * 1000000;
+  if (ts.tv_nsec >= 1000000000) {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000000000;
+  }
   return (int32_t)pthread_cond_timedwait(x, y, &ts);
 }
 
+int32_t SKIP_cond_timedwait(pthread_cond_t* x, pthread_mutex_t* y,
+                            uint32_t secs) {
+  return SKIP_cond_timedwait_ms(x, y, (int64_t)secs * 1000);
+}
+
 int32_t SKIP_cond_broadcast(void* c) {
   return (int32_t)pthread_cond_broadcast(c);
 }
@@ -493,6 +597,7 @@ struct file_mapping {
   uint64_t gid;
   size_t capacity;
   void** pconsts;
+  uint64_t pconsts_fingerprint;
   char persistent_fileName[1];
 };
 
@@ -531,6 +636,7 @@ void sk_create_mapping(char* fileName, size_t icapacity) {
   gid = &mapping->gid;
   capacity = &mapping->capacity;
   pconsts = &mapping->pconsts;
+  pconsts_fingerprint = &mapping->pconsts_fingerprint;
 
   size_t fileName_length = (fileName != NULL) ? strlen(fileName) + 1 : 0;
   char* persistent_fileName = mapping->persistent_fileName;
@@ -569,6 +675,7 @@ void sk_create_mapping(char* fileName, size_t icapacity) {
   }
   *capacity = icapacity;
   *pconsts = NULL;
+  *pconsts_fingerprint = 0;
 
   if (ginfo->fileName != NULL) {
     sk_global_lock_init();
@@ -617,6 +724,7 @@ void sk_load_mapping(char* fileName) {
   gid = &mapping->gid;
   capacity = &mapping->capacity;
   pconsts = &mapping->pconsts;
+  pconsts_fingerprint = &mapping->pconsts_fingerprint;
 }
 
 /*****************************************************************************/
@@ -679,6 +787,7 @@ typedef struct {
   ginfo_t ginfo_data;
   uint64_t gid;
   void** pconsts;
+  uint64_t pconsts_fingerprint;
 } no_file_t;
 
 #ifdef __APPLE__
@@ -695,8 +804,10 @@ static void sk_init_no_file() {
   gmutex = NULL;
   gid = &no_file->gid;
   pconsts = &no_file->pconsts;
+  pconsts_fingerprint = &no_file->pconsts_fingerprint;
   *gid = 1;
   *pconsts = NULL;
+  *pconsts_fingerprint = 0;
 }
 #endif
 
@@ -745,7 +856,9 @@ void SKIP_memory_init(int argc, char** argv) {
 /*****************************************************************************/
 
 void SKIP_print_persistent_size() {
+  SKIP_flush_stdout();
   printf("%ld\n", ginfo->total_palloc_size);
+  fflush(stdout);
 }
 
 void* sk_palloc(size_t size) {
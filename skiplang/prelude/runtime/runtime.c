@@ -66,11 +66,18 @@ void SKIP_contexts_init(Contexts obj) {
 
 void SKIP_contexts_replace_unsafe(Contexts new_contexts, uint32_t sync) {
   Contexts contexts = SKIP_contexts_get_unsafe();
-  sk_commit(SKIP_intern_shared(new_contexts), sync);
+  sk_rc_log_open();
+  Contexts interned = SKIP_intern_shared(new_contexts);
+  if (sync) {
+    // The reference counts must be on disk before the new root is.
+    sk_rc_log_flush();
+  }
+  sk_commit(interned, sync);
   // free current reference
   sk_free_root(contexts);
   // free global reference
   sk_free_root(contexts);
+  sk_rc_log_close();
 }
 
 void SKIP_unsafe_contexts_incr_ref_count(Contexts obj) {
@@ -90,9 +97,15 @@ void SKIP_global_lock() {
 }
 
 #ifdef SKIP64
-extern int sk_is_locked;
+extern __thread int sk_is_locked;
 #endif
 
+// Whether the current thread holds the global lock. The threads running a
+// Parallel.tabulate job for a thread holding the lock share it: they take it
+// without blocking on the caller (serialized with each other), but none of
+// them, the caller included, holds it outside of those sections. The body of
+// a tabulate must thus only reach the persistent heap through functions that
+// take the lock themselves (interning, constants, external pointers).
 uint32_t SKIP_global_has_lock() {
 #ifdef SKIP64
   return (uint32_t)sk_is_locked;
@@ -131,7 +144,13 @@ sk_contexts_with_actions_t SKIP_context_sync_no_lock(
   char* rtmp = SKIP_resolve_context(txTime, root, delta, synchronizer, lockF);
   sk_contexts_with_actions_t res =
       SKIP_check_fork_context(contexts, fork, rtmp);
+  // Reference count updates are coalesced until the old roots are released.
+  sk_rc_log_open();
   Contexts new_contexts = SKIP_intern_shared(res.contexts);
+  if (sync) {
+    // The reference counts must be on disk before the new root is.
+    sk_rc_log_flush();
+  }
   sk_commit(new_contexts, sync);
   sk_free_root(old_contexts);
   // free current reference
@@ -139,6 +158,7 @@ sk_contexts_with_actions_t SKIP_context_sync_no_lock(
   // free global reference
   sk_free_root(contexts);
   sk_free_external_pointers();
+  sk_rc_log_close();
 #ifdef CTX_TABLE
   sk_print_ctx_table();
 #endif
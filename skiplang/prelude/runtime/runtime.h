@@ -194,6 +194,18 @@ typedef struct {
 
 #define ty_is_array(ty) ((ty)->m_kind == kSkipGcKindArray)
 
+/* Interned objects are preceded by a header that is not part of their
+   uninterned representation. It holds the reference count and, on 64 bits,
+   the memoized structural hash of the object (0 when not computed yet, see
+   hash.c). The hash sits right before the reference count.
+*/
+#ifdef SKIP64
+#define sk_intern_header_size (sizeof(uint64_t) + sizeof(uintptr_t))
+#endif
+#ifdef SKIP32
+#define sk_intern_header_size (sizeof(uintptr_t))
+#endif
+
 SKIP_gc_type_t* get_gc_type(char* skip_object);
 
 /*****************************************************************************/
@@ -337,9 +349,12 @@ void SKIP_invalid_utf8();
 SkipInt SKIP_isEq(char* obj1, char* obj2);
 uint32_t SKIP_is_string(char* obj);
 void SKIP_print_char(uint32_t);
+void SKIP_flush_stdout();
+#ifdef SKIP32
 int32_t SKIP_read_line_fill();
 int32_t SKIP_read_to_end_fill();
 uint32_t SKIP_read_line_get(uint32_t);
+#endif
 Context SKIP_resolve_context(uint64_t, Context context, Context obj,
                              char* synchronizer, char* lockedF);
 void SKIP_call_after_unlock(char*, Context);
@@ -382,7 +397,9 @@ void sk_pfree_size(void*, size_t);
 size_t sk_pow2_size(size_t);
 void sk_print_int(SkipInt);
 void sk_staging();
+char* sk_string_alloc(uint32_t size);
 char* sk_string_create(const char* buffer, uint32_t size);
+void sk_string_set_hash(char* obj);
 void sk_string_check_c_safe(char* str);
 void throw_Invalid_utf8();
 void todo(char* err, char* msg);
@@ -396,6 +413,21 @@ void sk_check_has_lock();
 void sk_free_obj(sk_stack_t* st, char* obj);
 void sk_free_external_pointers();
 uintptr_t sk_get_ref_count(void* obj);
+void sk_rc_log_open();
+void sk_rc_log_flush();
+void sk_rc_log_close();
+void sk_rc_log_forget(void* obj);
+#ifdef SKIP64
+uint64_t* sk_get_hash_addr(void* obj);
+int sk_global_lock_share();
+void sk_global_lock_join(int shared);
+void sk_global_lock_unshare(int shared);
+int sk_io_write_all(int fd, const char* buf, size_t size);
+int sk_io_write_cached(const char* path, int flags, int mode, const char* buf,
+                       size_t size, int64_t offset);
+#endif
+int sk_hash_memo_differs(char* obj1, char* obj2);
+void sk_hash_interned(void* obj);
 void SKIP_throwInvalidSynchronization();
 void SKIP_call_finalize(char*, char*);
 void SKIP_exit(SkipInt);
@@ -224,6 +224,10 @@ int32_t SKIP_cond_timedwait(void* /* x */, void* /* y */, uint32_t /* secs */) {
   return 0;
 }
 
+int32_t SKIP_cond_timedwait_ms(void* /* x */, void* /* y */, int64_t /* ms */) {
+  return 0;
+}
+
 int32_t SKIP_cond_broadcast(void* /* c */) {
   return 0;
 }
@@ -268,6 +272,20 @@ int64_t SKIP_posix_read(int64_t fd, char* buf, int64_t len) {
   return (int64_t)SKIP_js_read((uint32_t)fd, buf, (uint32_t)len);
 }
 
+// Writes are not queued on 32-bit/WASM.
+int64_t SKIP_io_append(char* filename, char* str) {
+  int32_t flags = SKIP_js_open_flags(false, true, true, false, true, false);
+  int32_t fd = SKIP_js_open(filename, flags, 0777);
+  SKIP_js_write((uint32_t)fd, str, SKIP_String_byteSize(str));
+  SKIP_js_close(fd);
+  return 0;
+}
+
+int64_t SKIP_io_flush_file(char* filename) {
+  (void)filename;
+  return 0;
+}
+
 int32_t SKIP_js_get_argc();
 
 int64_t SKIP_getArgc() {
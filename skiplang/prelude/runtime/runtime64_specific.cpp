@@ -21,15 +21,19 @@ extern "C" {
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <exception>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <random>
 #include <string>
 #include <thread>
@@ -39,9 +43,6 @@ extern "C" {
 #include "xoroshiro128plus.h"
 }
 
-#ifndef RELEASE
-#include <backtrace.h>
-
 typedef struct {
   char* head;
   char* page;
@@ -53,8 +54,14 @@ void* sk_get_exception_type(void* skExn);
 void* sk_get_exception_message(void* skExn);
 sk_saved_obstack_t* SKIP_new_Obstack();
 void SKIP_destroy_Obstack(sk_saved_obstack_t* saved);
+void sk_destroy_Obstack_with_pages(sk_saved_obstack_t* saved, size_t nbr_pages,
+                                   sk_cell_t* pages);
+char* SKIP_callTabulateLambda(char* f, int64_t i);
 }
 
+#ifndef RELEASE
+#include <backtrace.h>
+
 namespace {
 
 struct backtrace_data {
@@ -127,9 +134,14 @@ void printStackTrace() {
 #endif
 }  // namespace skip
 
-#ifndef RELEASE
+extern "C" {
+void sk_stdout_flush_before_abort();
+}
+
 namespace {
 void terminate() {
+  sk_stdout_flush_before_abort();
+#ifndef RELEASE
   // TODO: Only print backtrace in debug mode.
   try {
     std::exception_ptr eptr = std::current_exception();
@@ -144,9 +156,252 @@ void terminate() {
   }
   std::cerr << "*** Stack trace:" << std::endl;
   skip::printStackTrace();
+#endif
 }
 }  // namespace
-#endif
+
+/*****************************************************************************/
+/* Thread pool backing Parallel.tabulate.
+ *
+ * The workers are started once and reused by every call. The indices of a
+ * job are handed out one at a time through an atomic counter, so a worker
+ * that is done with a cheap index immediately moves on to the next one. The
+ * calling thread takes part in the evaluation too.
+ *
+ * Each worker evaluates its indices in a fresh obstack of its own (the
+ * obstack state is thread local). Once every index is done, the caller copies
+ * the results (and the exception with the lowest index, if any) to its own
+ * obstack, and the workers destroy theirs.
+ *
+ * When the caller holds the global lock, the job shares it (see
+ * sk_global_lock_share): the workers can take the lock while the caller
+ * waits for them, instead of blocking on it.
+ */
+/*****************************************************************************/
+
+namespace {
+
+struct TabulateWorker {
+  std::vector<std::pair<int64_t, char*>> values;
+  int64_t exnIndex;
+  // The Skip exception thrown at exnIndex, or the C++ one in error.
+  void* exn;
+  std::exception_ptr error;
+  sk_saved_obstack_t* saved;
+  size_t nbr_pages;
+  sk_cell_t* pages;
+};
+
+class TabulatePool {
+ public:
+  explicit TabulatePool(size_t nbr_workers) : m_workers(nbr_workers) {
+    for (size_t id = 0; id < nbr_workers; id++) {
+      std::thread thread(&TabulatePool::workerLoop, this, id);
+      thread.detach();
+    }
+  }
+
+  // Evaluates the indices 1 to count - 1 (the caller already took care of
+  // 0). Returns false if the pool is already in use, which happens with
+  // nested calls: the caller is then expected to evaluate sequentially.
+  // The exception thrown at the smallest index, if any, is rethrown once
+  // all the workers are done.
+  bool run(char* f, int64_t count, char** results) {
+    bool expected = false;
+    if (!m_busy.compare_exchange_strong(expected, true)) {
+      return false;
+    }
+
+    RunScope scope(*this);
+    m_f = f;
+    m_count = count;
+    m_next.store(1);
+    m_failed.store(count);
+
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_running = m_workers.size();
+      m_alive = m_workers.size();
+      m_generation++;
+    }
+    m_cv.notify_all();
+
+    TabulateWorker self;
+    evaluate(self);
+    scope.waitWorkers();
+
+    int64_t failed = m_failed.load();
+    void* exn = nullptr;
+    std::exception_ptr error;
+    if (failed == self.exnIndex) {
+      exn = self.exn;
+      error = self.error;
+    }
+
+    for (auto& value : self.values) {
+      results[value.first] = value.second;
+    }
+    for (auto& w : m_workers) {
+      for (auto& value : w.values) {
+        results[value.first] = (char*)SKIP_copy_with_pages(
+            value.second, w.nbr_pages, w.pages);
+      }
+      if (failed == w.exnIndex) {
+        error = w.error;
+        if (w.exn != nullptr) {
+          exn = SKIP_copy_with_pages(w.exn, w.nbr_pages, w.pages);
+        }
+      }
+    }
+
+    if (error != nullptr) {
+      std::rethrow_exception(error);
+    }
+    if (exn != nullptr) {
+      SKIP_throw(exn);
+    }
+    return true;
+  }
+
+ private:
+  // Shares the global lock with the workers for the duration of a run.
+  // However the run exits, the workers are waited for, the lock is taken
+  // back, and the pool can be used again.
+  class RunScope {
+   public:
+    explicit RunScope(TabulatePool& pool)
+        : m_pool(pool), m_shared(sk_global_lock_share()) {
+      m_pool.m_shared = m_shared;
+    }
+
+    ~RunScope() {
+      waitWorkers();
+      {
+        std::unique_lock<std::mutex> lock(m_pool.m_mutex);
+        m_pool.m_released = m_pool.m_generation;
+      }
+      m_pool.m_cv.notify_all();
+      {
+        std::unique_lock<std::mutex> lock(m_pool.m_mutex);
+        m_pool.m_cv.wait(lock, [&] { return m_pool.m_alive == 0; });
+      }
+      m_pool.m_busy.store(false);
+    }
+
+    // Waits for the workers to be done evaluating, their results stay alive
+    // until the scope ends.
+    void waitWorkers() {
+      {
+        std::unique_lock<std::mutex> lock(m_pool.m_mutex);
+        m_pool.m_cv.wait(lock, [&] { return m_pool.m_running == 0; });
+      }
+      sk_global_lock_unshare(m_shared);
+      m_shared = 0;
+    }
+
+   private:
+    TabulatePool& m_pool;
+    int m_shared;
+  };
+
+  // Never throws: the first exception of the worker is recorded in it.
+  void evaluate(TabulateWorker& w) {
+    w.values.clear();
+    w.exnIndex = -1;
+    w.exn = nullptr;
+    w.error = nullptr;
+    while (true) {
+      int64_t i = m_next.fetch_add(1);
+      if (i >= m_count || i > m_failed.load()) {
+        return;
+      }
+      try {
+        w.values.emplace_back(i, SKIP_callTabulateLambda(m_f, i));
+      } catch (skip::SkipException& e) {
+        w.exn = e.m_skipException;
+        fail(w, i);
+        return;
+      } catch (...) {
+        w.error = std::current_exception();
+        fail(w, i);
+        return;
+      }
+    }
+  }
+
+  // Records that index i of w failed, the other indices past i are skipped.
+  void fail(TabulateWorker& w, int64_t i) {
+    w.exnIndex = i;
+    int64_t failed = m_failed.load();
+    while (i < failed && !m_failed.compare_exchange_weak(failed, i)) {
+    }
+  }
+
+  void workerLoop(size_t id) {
+    TabulateWorker& w = m_workers[id];
+    uint64_t generation = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [&] { return m_generation != generation; });
+        generation = m_generation;
+      }
+
+      w.saved = SKIP_new_Obstack();
+      sk_global_lock_join(m_shared);
+      evaluate(w);
+      sk_global_lock_join(0);
+      w.nbr_pages = sk_get_nbr_pages(NULL, NULL);
+      w.pages = sk_get_pages(NULL, w.nbr_pages);
+
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_running--;
+        m_cv.notify_all();
+        m_cv.wait(lock, [&] { return m_released == generation; });
+      }
+
+      sk_destroy_Obstack_with_pages(w.saved, w.nbr_pages, w.pages);
+      sk_free_size(w.pages, sizeof(sk_cell_t) * w.nbr_pages);
+      w.values.clear();
+      w.error = nullptr;
+
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_alive--;
+      }
+      m_cv.notify_all();
+    }
+  }
+
+  std::vector<TabulateWorker> m_workers;
+  std::atomic<bool> m_busy{false};
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  uint64_t m_generation = 0;
+  uint64_t m_released = 0;
+  size_t m_running = 0;
+  size_t m_alive = 0;
+  char* m_f = nullptr;
+  int m_shared = 0;
+  int64_t m_count = 0;
+  std::atomic<int64_t> m_next{0};
+  std::atomic<int64_t> m_failed{0};
+};
+
+int64_t readNumThreads() {
+  char* str = getenv("SKIP_NUM_THREADS");
+  if (str == NULL) {
+    return 1;
+  }
+  int64_t n = atoll(str);
+  if (n <= 0) {
+    n = std::thread::hardware_concurrency();
+  }
+  return n > 0 ? n : 1;
+}
+
+}  // namespace
 
 extern "C" {
 
@@ -165,6 +420,7 @@ void sk_string_check_c_safe(char* str) {
             str, size, len);
     fwrite(str, size, 1, stderr);
     fprintf(stderr, "\n");
+    sk_stdout_flush_before_abort();
     abort();
   } else if (len > size) {
     fprintf(stderr,
@@ -172,36 +428,207 @@ void sk_string_check_c_safe(char* str) {
             str, size, len);
     fwrite(str, size, 1, stderr);
     fprintf(stderr, "\n");
+    sk_stdout_flush_before_abort();
     abort();
   }
 }
 
+// Stdout is buffered by the runtime rather than by stdio, so that a string
+// that does not fit in the buffer is written along with it in a single
+// writev(2). The buffer is written when SKIP_flush_stdout is called, before
+// stdin is read, when the program exits or aborts, and, when stdout is a
+// terminal, after every newline.
+#define SK_STDOUT_BUFFER_SIZE (1 << 16)
+
+static char stdout_buffer[SK_STDOUT_BUFFER_SIZE];
+static size_t stdout_size = 0;
+static int stdout_is_tty = -1;
+static std::mutex stdout_mutex;
+
+static void sk_stdout_writev(struct iovec* iov, int iovcnt) {
+  while (iovcnt > 0) {
+    ssize_t written = writev(STDOUT_FILENO, iov, iovcnt);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      // Like stdio, the output is lost when stdout can't be written.
+      return;
+    }
+    while (iovcnt > 0 && (size_t)written >= iov->iov_len) {
+      written -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (iovcnt > 0) {
+      iov->iov_base = (char*)iov->iov_base + written;
+      iov->iov_len -= written;
+    }
+  }
+}
+
+static void sk_stdout_flush_locked() {
+  if (stdout_size == 0) {
+    return;
+  }
+  struct iovec iov = {stdout_buffer, stdout_size};
+  sk_stdout_writev(&iov, 1);
+  stdout_size = 0;
+}
+
+// The abort may come from the thread that holds the lock, in which case the
+// buffer is left as it is.
+void sk_stdout_flush_before_abort() {
+  std::unique_lock<std::mutex> lock(stdout_mutex, std::try_to_lock);
+  if (lock.owns_lock()) {
+    sk_stdout_flush_locked();
+  }
+}
+
+static void sk_stdout_at_exit() {
+  std::lock_guard<std::mutex> lock(stdout_mutex);
+  sk_stdout_flush_locked();
+}
+
+static void sk_stdout_write(const char* data, size_t size) {
+  std::lock_guard<std::mutex> lock(stdout_mutex);
+  if (stdout_is_tty == -1) {
+    stdout_is_tty = isatty(STDOUT_FILENO);
+    atexit(sk_stdout_at_exit);
+  }
+  if (stdout_size + size <= SK_STDOUT_BUFFER_SIZE) {
+    memcpy(stdout_buffer + stdout_size, data, size);
+    stdout_size += size;
+  } else {
+    struct iovec iov[2] = {{stdout_buffer, stdout_size},
+                           {(void*)data, size}};
+    sk_stdout_writev(iov, 2);
+    stdout_size = 0;
+  }
+  if (stdout_is_tty && memchr(data, '\n', size) != NULL) {
+    sk_stdout_flush_locked();
+  }
+}
+
 void SKIP_print_char(uint32_t x) {
-  printf("%c", x);
+  char c = (char)x;
+  sk_stdout_write(&c, 1);
 }
 
 void SKIP_throw(void* exc) {
   throw skip::SkipException(exc);
 }
 
-thread_local std::string lineBuffer;
+// Stdin is read in large blocks, the lines are copied once, straight from
+// the block into their string.
+#define SK_STDIN_BLOCK_SIZE (1 << 16)
+
+static char* stdin_buffer = NULL;
+static size_t stdin_capacity = 0;
+static size_t stdin_start = 0;
+static size_t stdin_end = 0;
+static bool stdin_eof = false;
+static std::mutex stdin_mutex;
+
+// Reads more of stdin after the bytes that are still buffered, growing the
+// buffer when they fill it. Returns false at the end of the input.
+static bool sk_stdin_fill() {
+  if (stdin_eof) {
+    return false;
+  }
+  if (stdin_start > 0) {
+    memmove(stdin_buffer, stdin_buffer + stdin_start, stdin_end - stdin_start);
+    stdin_end -= stdin_start;
+    stdin_start = 0;
+  }
+  if (stdin_end == stdin_capacity) {
+    size_t capacity =
+        stdin_capacity == 0 ? SK_STDIN_BLOCK_SIZE : stdin_capacity * 2;
+    char* buffer = (char*)realloc(stdin_buffer, capacity);
+    if (buffer == NULL) {
+      perror("realloc");
+      exit(ERROR_OUT_OF_MEMORY);
+    }
+    stdin_buffer = buffer;
+    stdin_capacity = capacity;
+  }
+  // The read may block: what was printed so far (e.g. a prompt) must be
+  // visible first.
+  {
+    std::lock_guard<std::mutex> lock(stdout_mutex);
+    sk_stdout_flush_locked();
+  }
+  ssize_t nread;
+  do {
+    nread = read(STDIN_FILENO, stdin_buffer + stdin_end,
+                 stdin_capacity - stdin_end);
+  } while (nread < 0 && errno == EINTR);
+  if (nread <= 0) {
+    stdin_eof = true;
+    return false;
+  }
+  stdin_end += nread;
+  return true;
+}
+
+// Returns the offset from stdin_start of the first newline at or after
+// offset, reading more of stdin until there is one. Returns the number of
+// buffered bytes when the input ends without a newline.
+static size_t sk_stdin_find_newline(size_t offset) {
+  for (;;) {
+    size_t buffered = stdin_end - stdin_start;
+    if (offset < buffered) {
+      char* line = stdin_buffer + stdin_start;
+      char* newline = (char*)memchr(line + offset, '\n', buffered - offset);
+      if (newline != NULL) {
+        return newline - line;
+      }
+      offset = buffered;
+    }
+    if (!sk_stdin_fill()) {
+      return stdin_end - stdin_start;
+    }
+  }
+}
 
-int32_t SKIP_read_line_fill(void) {
-  std::getline(std::cin, lineBuffer);
-  if (std::cin.fail()) {
-    return -1;
+char* SKIP_read_line() {
+  std::lock_guard<std::mutex> lock(stdin_mutex);
+  size_t size = sk_stdin_find_newline(0);
+  size_t buffered = stdin_end - stdin_start;
+  if (buffered == 0) {
+    return NULL;
   }
-  return lineBuffer.size();
+  char* result = sk_string_create(stdin_buffer + stdin_start, size);
+  stdin_start += size < buffered ? size + 1 : size;
+  return result;
 }
 
-int32_t SKIP_read_to_end_fill() {
-  std::istreambuf_iterator<char> begin(std::cin), end;
-  lineBuffer = std::string(begin, end);
-  return lineBuffer.size();
+char* SKIP_read_to_end() {
+  std::lock_guard<std::mutex> lock(stdin_mutex);
+  while (sk_stdin_fill()) {
+  }
+  size_t size = stdin_end - stdin_start;
+  char* result = sk_string_create(stdin_buffer + stdin_start, size);
+  stdin_start = stdin_end;
+  return result;
 }
 
-uint32_t SKIP_read_line_get(uint32_t i) {
-  return lineBuffer[i];
+// Returns the next lines of stdin, with their newlines, stopping after the
+// first line that reaches max_size bytes. The last line of the input may not
+// end with a newline. Returns an empty string at the end of the input.
+char* SKIP_read_chunk(int64_t max_size) {
+  std::lock_guard<std::mutex> lock(stdin_mutex);
+  size_t size = 0;
+  do {
+    size_t newline = sk_stdin_find_newline(size);
+    size_t buffered = stdin_end - stdin_start;
+    if (newline == buffered) {
+      size = buffered;
+      break;
+    }
+    size = newline + 1;
+  } while ((int64_t)size < max_size);
+  char* result = sk_string_create(stdin_buffer + stdin_start, size);
+  stdin_start += size;
+  return result;
 }
 
 thread_local void* exn;
@@ -291,7 +718,7 @@ static void print(FILE* descr, char* str) {
 }
 
 void SKIP_print_raw(char* str) {
-  print(stdout, str);
+  sk_stdout_write(str, SKIP_String_byteSize(str));
 }
 
 void SKIP_print_error_raw(char* str) {
@@ -302,14 +729,18 @@ void SKIP_print_debug_raw(char* str) {
   SKIP_print_error_raw(str);
 }
 
+// Stderr is not buffered.
 void SKIP_flush_stdout() {
+  {
+    std::lock_guard<std::mutex> lock(stdout_mutex);
+    sk_stdout_flush_locked();
+  }
   fflush(stdout);
-  fflush(stderr);
 }
 
 void print_string(char* str) {
-  print(stdout, str);
-  printf("\n");
+  sk_stdout_write(str, SKIP_String_byteSize(str));
+  sk_stdout_write("\n", 1);
 }
 
 void SKIP_print_error(char* str) {
@@ -338,43 +769,43 @@ char* SKIP_open_file(char* filename) {
     exit(ERROR_FILE_IO);
   }
   size_t size = s.st_size;
+  if (size > UINT32_MAX) {
+    fprintf(stderr, "File too large: %s\n", filename);
+    exit(ERROR_FILE_IO);
+  }
 
-  char* result;
-  if (size == 0) {
-    result = sk_string_create("", 0);
-  } else {
-    void* f = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
-    if (f == MAP_FAILED) {
-      perror("ERROR (MAP FAILED)");
-      fprintf(stderr, "Could not open file: %s\n", filename);
+  // The file is read straight into the string, rather than mapped and then
+  // copied, so that its pages are never held twice.
+  char* result = sk_string_alloc((uint32_t)size);
+  size_t offset = 0;
+  while (offset < size) {
+    ssize_t nread = read(fd, result + offset, size - offset);
+    if (nread < 0 && errno == EINTR) continue;
+    if (nread <= 0) {
+      perror("ERROR (read failed)");
+      fprintf(stderr, "Could not read file: %s\n", filename);
       exit(ERROR_FILE_IO);
     }
-    result = sk_string_create((char*)f, size);
-    munmap(f, size);
+    offset += nread;
   }
+  sk_string_set_hash(result);
   close(fd);
   return result;
 }
 
 void SKIP_write_to_file(int64_t fd, char* str) {
-  size_t size = SKIP_String_byteSize(str);
-  while (size > 0) {
-    ssize_t written = write(fd, str, size);
-    if (written < 0) {
-      int err = errno;
-      fprintf(stderr, "Could not write to file. %" PRId64 " (%d)\n", fd, err);
-      exit(ERROR_FILE_IO);
-    }
-    size -= written;
+  int rv = sk_io_write_all((int)fd, str, SKIP_String_byteSize(str));
+  if (rv != 0) {
+    fprintf(stderr, "Could not write to file. %" PRId64 " (%d)\n", fd, -rv);
+    exit(ERROR_FILE_IO);
   }
 }
 
 void SKIP_FileSystem_appendTextFile(char* filename, char* str_obj) {
   sk_string_check_c_safe(filename);
 
-  int fd = open(filename, O_WRONLY | O_CREAT | O_APPEND, 0775);
-  (void)write(fd, str_obj, SKIP_String_byteSize(str_obj));
-  close(fd);
+  (void)sk_io_write_cached(filename, O_WRONLY | O_CREAT | O_APPEND, 0775,
+                           str_obj, SKIP_String_byteSize(str_obj), -1);
 }
 
 bool SKIP_check_if_file_exists(char* filename) {
@@ -388,32 +819,14 @@ bool SKIP_check_if_file_exists(char* filename) {
 int32_t SKIP_notify(char* filename, int32_t tick) {
   sk_string_check_c_safe(filename);
 
-  int fd = open(filename, O_CREAT | O_WRONLY, 0644);
-
-  if (fd == -1) {
-    return -1;
-  }
-
-  char buf_data[256];
-  char* buf = buf_data;
+  char buf[256];
   snprintf(buf, 256, "%d\n", tick);
-  size_t size = strlen(buf);
-
-  while (size > 0) {
-    ssize_t written = write(fd, buf, size);
-    if (written == -1) {
-      close(fd);
-      return -1;
-    }
-    buf += written;
-    size -= written;
-  }
 
-  if (close(fd) == -1) {
-    return -1;
-  }
-
-  return 0;
+  // The file stays open from one tick to the next, the tick is written at
+  // the start of the file as if it had just been opened.
+  int rv = sk_io_write_cached(filename, O_CREAT | O_WRONLY, 0644, buf,
+                              strlen(buf), 0);
+  return rv == 0 ? 0 : -1;
 }
 
 void SKIP_random_init() {
@@ -494,8 +907,22 @@ void SKIP_chdir(char* path) {
   }
 }
 
+// The number of threads used by Parallel.tabulate is read from the
+// SKIP_NUM_THREADS environment variable (0 means one per core). It defaults
+// to 1, i.e. everything runs sequentially on the calling thread.
 int64_t SKIP_numThreads() {
-  return 1;
+  static int64_t nbr_threads = readNumThreads();
+  return nbr_threads;
+}
+
+void SKIP_parallelTabulate(int64_t count, char* f, char** results) {
+  static TabulatePool* pool = new TabulatePool(SKIP_numThreads() - 1);
+  if (pool->run(f, count, results)) {
+    return;
+  }
+  for (int64_t i = 1; i < count; i++) {
+    results[i] = SKIP_callTabulateLambda(f, i);
+  }
 }
 
 void SKIP_string_to_file(char* str, char* file) {
@@ -125,6 +125,7 @@ void todo(char*, char*) {
 }
 #endif
 
+#ifdef SKIP32
 char* SKIP_read_line() {
   int32_t size = SKIP_read_line_fill();
 
@@ -152,3 +153,22 @@ char* SKIP_read_to_end() {
 
   return sk_string_create(result, size);
 }
+
+// Lines are not buffered on 32-bit/WASM, a chunk is a single line.
+char* SKIP_read_chunk(SkipInt /* max_size */) {
+  int32_t size = SKIP_read_line_fill();
+
+  if (size < 0) {
+    return sk_string_create("", 0);
+  }
+
+  char* result = SKIP_Obstack_alloc(size + 1);
+
+  for (int32_t i = 0; i < size; i++) {
+    result[i] = SKIP_read_line_get(i);
+  }
+  result[size] = '\n';
+
+  return sk_string_create(result, size + 1);
+}
+#endif
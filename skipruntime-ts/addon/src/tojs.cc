@@ -18,6 +18,7 @@ char* SkipRuntime_Context__useExternalResource(char* service, char* identifier,
                                                CJObject json);
 
 SKMapper SkipRuntime_createMapper(int32_t ref);
+SKMapper SkipRuntime_createNativeMapper(char* mapper, CJArray collections);
 SKLazyCompute SkipRuntime_createLazyCompute(int32_t ref);
 SKResource SkipRuntime_createResource(int32_t ref);
 SKService SkipRuntime_createService(int32_t ref);
@@ -53,6 +54,7 @@ double SkipRuntime_Runtime__unsubscribe(char* identifier);
 CJSON SkipRuntime_Runtime__getAll(char* resource, CJObject jsonParams);
 CJSON SkipRuntime_Runtime__getForKey(char* resource, CJObject jsonParams,
                                      CJSON key);
+CJSON SkipRuntime_Runtime__getReducerStats();
 CJSON SkipRuntime_Runtime__update(char* input, CJSON values);
 double SkipRuntime_Runtime__fork(char* input);
 double SkipRuntime_Runtime__merge(CJArray);
@@ -214,6 +216,36 @@ void CreateMapper(const FunctionCallbackInfo<Value>& args) {
   });
 }
 
+void CreateNativeMapper(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  HandleScope scope(isolate);
+  if (args.Length() != 2) {
+    // Throw an Error that is passed back to JavaScript
+    isolate->ThrowException(
+        Exception::TypeError(FromUtf8(isolate, "Must have two parameters.")));
+    return;
+  };
+  if (!args[0]->IsString()) {
+    // Throw an Error that is passed back to JavaScript
+    isolate->ThrowException(Exception::TypeError(
+        FromUtf8(isolate, "The first parameter must be a string.")));
+    return;
+  }
+  if (!args[1]->IsExternal()) {
+    // Throw an Error that is passed back to JavaScript
+    isolate->ThrowException(Exception::TypeError(
+        FromUtf8(isolate, "The second parameter must be a pointer.")));
+    return;
+  };
+  NatTryCatch(isolate, [&args](Isolate* isolate) {
+    char* skMapperSpec = ToSKString(isolate, args[0].As<String>());
+    CJArray skCollections = args[1].As<External>()->Value();
+    SKMapper skMapper =
+        SkipRuntime_createNativeMapper(skMapperSpec, skCollections);
+    args.GetReturnValue().Set(External::New(isolate, skMapper));
+  });
+}
+
 void CreateLazyCompute(const FunctionCallbackInfo<Value>& args) {
   Isolate* isolate = args.GetIsolate();
   HandleScope scope(isolate);
@@ -835,6 +867,15 @@ void GetForKeyOfRuntime(const FunctionCallbackInfo<Value>& args) {
   });
 }
 
+void GetReducerStatsOfRuntime(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  HandleScope scope(isolate);
+  NatTryCatch(isolate, [&args](Isolate* isolate) {
+    CJSON skresult = SkipRuntime_Runtime__getReducerStats();
+    args.GetReturnValue().Set(External::New(isolate, skresult));
+  });
+}
+
 void UpdateOfRuntime(const FunctionCallbackInfo<Value>& args) {
   Isolate* isolate = args.GetIsolate();
   HandleScope scope(isolate);
@@ -992,6 +1033,8 @@ void GetToJSBinding(const FunctionCallbackInfo<Value>& args) {
               UseExternalResourceOfContext);
   //
   AddFunction(isolate, binding, "SkipRuntime_createMapper", CreateMapper);
+  AddFunction(isolate, binding, "SkipRuntime_createNativeMapper",
+              CreateNativeMapper);
   AddFunction(isolate, binding, "SkipRuntime_createLazyCompute",
               CreateLazyCompute);
   AddFunction(isolate, binding, "SkipRuntime_createResource", CreateResource);
@@ -1040,6 +1083,8 @@ void GetToJSBinding(const FunctionCallbackInfo<Value>& args) {
   AddFunction(isolate, binding, "SkipRuntime_Runtime__getAll", GetAllOfRuntime);
   AddFunction(isolate, binding, "SkipRuntime_Runtime__getForKey",
               GetForKeyOfRuntime);
+  AddFunction(isolate, binding, "SkipRuntime_Runtime__getReducerStats",
+              GetReducerStatsOfRuntime);
   AddFunction(isolate, binding, "SkipRuntime_Runtime__update", UpdateOfRuntime);
   AddFunction(isolate, binding, "SkipRuntime_Runtime__fork", ForkOfRuntime);
   AddFunction(isolate, binding, "SkipRuntime_Runtime__merge", MergeOfRuntime);
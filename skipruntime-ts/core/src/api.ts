@@ -403,6 +403,28 @@ export type CollectionUpdate<K extends Json, V extends Json> = {
   isInitial?: boolean;
 };
 
+/**
+ * Counters of the reducer of an eager collection, for debugging.
+ *
+ * The counters belong to the reducer of the collection, and start over at zero whenever the collection is created again (e.g. when a reload rebuilds the resources graph).
+ */
+export type ReducerStats = {
+  /**
+   * Identifier of the reduced collection.
+   */
+  collection: string;
+
+  /**
+   * Number of updates of the accumulated value of a key.
+   */
+  updates: number;
+
+  /**
+   * Number of those updates that could not remove a value incrementally, and recomputed the accumulated value of the key from all its values.
+   */
+  recomputes: number;
+};
+
 /**
  * Interface to an external service.
  *
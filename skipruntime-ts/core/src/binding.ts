@@ -47,6 +47,10 @@ export interface FromBinding {
   >(
     ref: Handle<HandlerInfo<Mapper<K1, V1, K2, V2>>>,
   ): Pointer<Internal.Mapper>;
+  SkipRuntime_createNativeMapper(
+    mapper: string,
+    collections: Pointer<Internal.CJArray<Internal.CJString>>,
+  ): Pointer<Internal.Mapper>;
 
   // LazyCompute
 
@@ -156,6 +160,10 @@ export interface FromBinding {
     key: Pointer<Internal.CJSON>,
   ): Pointer<Internal.CJArray | Internal.CJFloat>;
 
+  SkipRuntime_Runtime__getReducerStats(): Pointer<
+    Internal.CJArray | Internal.CJFloat
+  >;
+
   SkipRuntime_Runtime__closeResource(identifier: string): Handle<Error>;
 
   SkipRuntime_Runtime__subscribe(
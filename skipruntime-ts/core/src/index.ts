@@ -33,6 +33,7 @@ import {
   type Values,
   type DepSafe,
   type Reducer,
+  type ReducerStats,
   type Resource,
   type SkipService,
   type Watermark,
@@ -340,9 +341,7 @@ class EagerCollectionImpl<K extends Json, V extends Json>
     ...params: Params
   ): EagerCollection<K2, V2> {
     const mapperObj = instantiateUserObject("Mapper", mapper, params);
-    const skmapper = this.refs.binding.SkipRuntime_createMapper(
-      this.refs.handles.register(mapperObj),
-    );
+    const skmapper = this.createMapper(mapperObj);
     const mapped = this.refs.binding.SkipRuntime_Collection__map(
       this.collection,
       skmapper,
@@ -365,9 +364,7 @@ class EagerCollectionImpl<K extends Json, V extends Json>
         reducerParams,
       );
 
-      const skmapper = this.refs.binding.SkipRuntime_createMapper(
-        this.refs.handles.register(mapperObj),
-      );
+      const skmapper = this.createMapper(mapperObj);
 
       if (
         sknative in reducerObj.object &&
@@ -434,6 +431,28 @@ class EagerCollectionImpl<K extends Json, V extends Json>
     return this.derive<K, V>(mapped);
   }
 
+  private createMapper<K2 extends Json, V2 extends Json>(
+    mapperObj: HandlerInfo<Mapper<K, V, K2, V2>>,
+  ): Pointer<Internal.Mapper> {
+    if (
+      sknative in mapperObj.object &&
+      typeof mapperObj.object[sknative] == "string"
+    ) {
+      // Native mappers run in the runtime, the collections they join with
+      // are passed by name, in the order of the mapper parameters.
+      const collections = mapperObj.params
+        .filter((param) => param instanceof EagerCollectionImpl)
+        .map((param) => EagerCollectionImpl.getName(param));
+      return this.refs.binding.SkipRuntime_createNativeMapper(
+        mapperObj.object[sknative],
+        this.refs.json().exportJSON(collections),
+      );
+    }
+    return this.refs.binding.SkipRuntime_createMapper(
+      this.refs.handles.register(mapperObj),
+    );
+  }
+
   private derive<K2 extends Json, V2 extends Json>(
     collection: string,
   ): EagerCollection<K2, V2> {
@@ -669,6 +688,27 @@ export class ServiceInstance {
     }
   }
 
+  /**
+   * Get the counters of the reducers of the eager collections of the service
+   *
+   * The counters of a collection start over whenever it is created again, e.g. when a reload rebuilds the resources graph.
+   * @returns The counters of every eager collection with a reducer
+   */
+  getReducerStats(): ReducerStats[] {
+    this.refs.setFork(this.forkName);
+    const result = this.refs.runWithGC(() => {
+      return this.refs
+        .json()
+        .importJSON(
+          this.refs.binding.SkipRuntime_Runtime__getReducerStats(),
+          true,
+        );
+    });
+    if (typeof result == "number")
+      throw this.refs.handles.deleteHandle(result as Handle<Error>);
+    return result as ReducerStats[];
+  }
+
   /**
    * Close the specified resource instance
    * @param resourceInstanceId - The resource identifier
@@ -11,4 +11,26 @@ export {
 } from "./external.js";
 export { SkipExternalService, asLeader, asFollower } from "./remote.js";
 export { SkipServiceBroker, fetchJSON, type Entrypoint } from "./rest.js";
-export { Count, Max, Min, Sum } from "./utils.js";
+export {
+  Explode,
+  Filter,
+  Join,
+  KeyBy,
+  Pipeline,
+  Project,
+  type FilterOperator,
+  type NativeMapperStep,
+} from "./mappers.js";
+export {
+  Avg,
+  Count,
+  DistinctCount,
+  Histogram,
+  Max,
+  Min,
+  Sum,
+  TopK,
+  Variance,
+  type TopKAccum,
+  type VarianceAccum,
+} from "./utils.js";
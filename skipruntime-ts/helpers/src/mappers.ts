@@ -0,0 +1,180 @@
+import { /* type NativeStub, */ sknative } from "../skiplang-std/index.js";
+import type {
+  EagerCollection,
+  Json,
+  JsonObject,
+  Managed,
+  Mapper,
+  Values,
+} from "@skipruntime/core";
+
+/**
+ * Comparison operators of the `Filter` mapper.
+ */
+export type FilterOperator = "==" | "!=" | "<" | "<=" | ">" | ">=";
+
+/**
+ * A step of a `Pipeline` mapper.
+ *
+ * A `field` is a list of field names separated by dots, the empty string being the value itself. Values without such a field are dropped by the step.
+ *
+ * - `{ project: pattern }`: one value per match of the `Context.jsonExtract` pattern, an object with the captured variables.
+ * - `{ filter: field, op, value }`: keeps the values whose `field` compares to `value` with `op`.
+ * - `{ keyBy: field }`: re-keys every value by its `field`.
+ * - `{ explode: field }`: one value per element of the array in `field`.
+ * - `{ join: i }`: pairs every value with each value at the same key in the `i`-th collection given to the `Pipeline`, as `[value, other]`.
+ */
+export type NativeMapperStep =
+  | { project: string }
+  | { filter: string; op: FilterOperator; value: Json }
+  | { keyBy: string }
+  | { explode: string }
+  | { join: number };
+
+/**
+ * `Mapper` running a sequence of native steps.
+ *
+ * A `Mapper` whose steps run in the Skip runtime, without calling back into JavaScript for each key. Every step maps the entries produced by the previous one.
+ */
+export class Pipeline<
+  K1 extends Json,
+  V1 extends Json,
+  K2 extends Json,
+  V2 extends Json,
+> implements /* NativeStub, */ Mapper<K1, V1, K2, V2>
+{
+  /** @hidden */
+  [sknative]: string;
+
+  /**
+   * @param steps - The steps of the mapper, deep-frozen with `deepFreeze`.
+   * @param _collections - The collections of the `join` steps.
+   */
+  constructor(
+    steps: NativeMapperStep[] & Managed,
+    ..._collections: EagerCollection<Json, Json>[]
+  ) {
+    this[sknative] = JSON.stringify(steps);
+  }
+
+  // Lie to TypeScript that this implements Mapper, but leave out any implementations
+  // since we provide a native implementation.
+  mapEntry!: (key: K1, values: Values<V1>) => Iterable<[K2, V2]>;
+}
+
+/**
+ * `Mapper` to extract fields from values.
+ *
+ * A `Mapper` that maps each value to one object per match of a `Context.jsonExtract` pattern, holding the variables captured by the match.
+ */
+export class Project<K extends Json, V extends Json, V2 extends JsonObject>
+  implements /* NativeStub, */ Mapper<K, V, K, V2>
+{
+  /** @hidden */
+  [sknative]: string;
+
+  /**
+   * @param pattern - The pattern to match values against.
+   */
+  constructor(pattern: string) {
+    this[sknative] = JSON.stringify([{ project: pattern }]);
+  }
+
+  // Lie to TypeScript that this implements Mapper, but leave out any implementations
+  // since we provide a native implementation.
+  mapEntry!: (key: K, values: Values<V>) => Iterable<[K, V2]>;
+}
+
+/**
+ * `Mapper` to keep the values satisfying a predicate.
+ *
+ * A `Mapper` that keeps the values whose `field` compares to `value` with `op`, using the ordering of JSON values of the Skip runtime.
+ */
+export class Filter<K extends Json, V extends Json>
+  implements /* NativeStub, */ Mapper<K, V, K, V>
+{
+  /** @hidden */
+  [sknative]: string;
+
+  /**
+   * @param field - The field to compare, as field names separated by dots.
+   * @param op - The comparison operator.
+   * @param value - The value to compare the field to.
+   */
+  constructor(field: string, op: FilterOperator, value: Json) {
+    this[sknative] = JSON.stringify([{ filter: field, op, value }]);
+  }
+
+  // Lie to TypeScript that this implements Mapper, but leave out any implementations
+  // since we provide a native implementation.
+  mapEntry!: (key: K, values: Values<V>) => Iterable<[K, V]>;
+}
+
+/**
+ * `Mapper` to re-key values by one of their fields.
+ *
+ * A `Mapper` that associates each value to its `field`.
+ */
+export class KeyBy<K extends Json, V extends Json, K2 extends Json>
+  implements /* NativeStub, */ Mapper<K, V, K2, V>
+{
+  /** @hidden */
+  [sknative]: string;
+
+  /**
+   * @param field - The field to use as key, as field names separated by dots.
+   */
+  constructor(field: string) {
+    this[sknative] = JSON.stringify([{ keyBy: field }]);
+  }
+
+  // Lie to TypeScript that this implements Mapper, but leave out any implementations
+  // since we provide a native implementation.
+  mapEntry!: (key: K, values: Values<V>) => Iterable<[K2, V]>;
+}
+
+/**
+ * `Mapper` to flatten arrays.
+ *
+ * A `Mapper` that maps each value to the elements of the array in its `field`, or of the value itself when `field` is empty.
+ */
+export class Explode<K extends Json, V extends Json, V2 extends Json>
+  implements /* NativeStub, */ Mapper<K, V, K, V2>
+{
+  /** @hidden */
+  [sknative]: string;
+
+  /**
+   * @param field - The field holding the array, as field names separated by dots.
+   */
+  constructor(field = "") {
+    this[sknative] = JSON.stringify([{ explode: field }]);
+  }
+
+  // Lie to TypeScript that this implements Mapper, but leave out any implementations
+  // since we provide a native implementation.
+  mapEntry!: (key: K, values: Values<V>) => Iterable<[K, V2]>;
+}
+
+/**
+ * `Mapper` to join two collections on their keys.
+ *
+ * A `Mapper` that pairs each value with each value associated to the same key in `other`, as `[value, other]`. Keys without values in `other` are dropped.
+ */
+export class Join<K extends Json, V extends Json, V2 extends Json>
+  implements /* NativeStub, */ Mapper<K, V, K, [V, V2]>
+{
+  /** @hidden */
+  [sknative]: string;
+
+  /**
+   * @param _other - The collection to join with.
+   */
+  constructor(_other: EagerCollection<K, V2>) {
+    this[sknative] = JSON.stringify([{ join: 0 }]);
+  }
+
+  // Lie to TypeScript that this implements Mapper, but leave out any implementations
+  // since we provide a native implementation.
+  mapEntry!: (key: K, values: Values<V>) => Iterable<[K, [V, V2]]>;
+}
@@ -66,3 +66,154 @@ export class Count<T extends Json>
   add!: (accum: number) => number;
   remove!: (accum: number) => Nullable<number>;
 }
+
+/**
+ * `Reducer` to maintain the average of input values.
+ *
+ * A `Reducer` that maintains the average of values as they are added and removed from a collection, along with their count and sum. The average is `null` when there are no values.
+ */
+export class Avg
+  implements
+    /* NativeStub, */ Reducer<
+      number,
+      { avg: number | null; count: number; sum: number }
+    >
+{
+  /** @hidden */
+  [sknative] = "avg";
+
+  // Lie to TypeScript that this implements Reducer, but leave out any implementations
+  // since we provide a native implementation.
+  initial!: { avg: number | null; count: number; sum: number };
+  add!: (accum: {
+    avg: number | null;
+    count: number;
+    sum: number;
+  }) => { avg: number | null; count: number; sum: number };
+  remove!: (accum: {
+    avg: number | null;
+    count: number;
+    sum: number;
+  }) => Nullable<{ avg: number | null; count: number; sum: number }>;
+}
+
+/**
+ * The state of the `Variance` reducer.
+ */
+export type VarianceAccum = {
+  count: number;
+  /** The sum of the squared differences to the mean. */
+  m2: number;
+  mean: number | null;
+  stddev: number | null;
+  variance: number | null;
+};
+
+/**
+ * `Reducer` to maintain the population variance and standard deviation of input values.
+ *
+ * A `Reducer` that maintains the mean, variance and standard deviation of values as they are added and removed from a collection. They are `null` when there are no values.
+ */
+export class Variance
+  implements /* NativeStub, */ Reducer<number, VarianceAccum>
+{
+  /** @hidden */
+  [sknative] = "variance";
+
+  // Lie to TypeScript that this implements Reducer, but leave out any implementations
+  // since we provide a native implementation.
+  initial!: VarianceAccum;
+  add!: (accum: VarianceAccum) => VarianceAccum;
+  remove!: (accum: VarianceAccum) => Nullable<VarianceAccum>;
+}
+
+/**
+ * The state of the `TopK` reducer.
+ */
+export type TopKAccum<T extends Json> = {
+  count: number;
+  spill: T[];
+  top: T[];
+};
+
+/**
+ * `Reducer` to maintain the largest input values.
+ *
+ * A `Reducer` that maintains the `k` largest values, in decreasing order, as they are added and removed from a collection. Up to `k` more values are kept in `spill`, so that removing one of the largest values does not require going through all of them again.
+ */
+export class TopK<T extends Json>
+  implements /* NativeStub, */ Reducer<T, TopKAccum<T>>
+{
+  /** @hidden */
+  [sknative]: string;
+
+  /**
+   * @param k - The number of values to keep.
+   */
+  constructor(k: number) {
+    this[sknative] = `topk:${k}`;
+  }
+
+  // Lie to TypeScript that this implements Reducer, but leave out any implementations
+  // since we provide a native implementation.
+  initial!: TopKAccum<T>;
+  add!: (accum: TopKAccum<T>) => TopKAccum<T>;
+  remove!: (accum: TopKAccum<T>) => Nullable<TopKAccum<T>>;
+}
+
+/**
+ * `Reducer` to estimate the number of distinct input values.
+ *
+ * A `Reducer` that estimates the number of distinct values in a collection with HyperLogLog, with a standard error of about 3%. Removing a value requires going through all of them again.
+ */
+export class DistinctCount<T extends Json>
+  implements
+    /* NativeStub, */ Reducer<T, { estimate: number; registers: string }>
+{
+  /** @hidden */
+  [sknative] = "distinct";
+
+  // Lie to TypeScript that this implements Reducer, but leave out any implementations
+  // since we provide a native implementation.
+  initial!: { estimate: number; registers: string };
+  add!: (accum: { estimate: number; registers: string }) => {
+    estimate: number;
+    registers: string;
+  };
+  remove!: (accum: {
+    estimate: number;
+    registers: string;
+  }) => Nullable<{ estimate: number; registers: string }>;
+}
+
+/**
+ * `Reducer` to maintain a histogram of input values.
+ *
+ * A `Reducer` that counts the values that fall in fixed buckets as they are added and removed from a collection. With `n` bounds, `counts[0]` is the number of values below `bounds[0]`, `counts[i]` the number of values in `[bounds[i-1], bounds[i])`, and `counts[n]` the number of values above `bounds[n-1]`.
+ */
+export class Histogram
+  implements
+    /* NativeStub, */ Reducer<number, { bounds: number[]; counts: number[] }>
+{
+  /** @hidden */
+  [sknative]: string;
+
+  /**
+   * @param bounds - The bounds of the buckets.
+   */
+  constructor(bounds: number[]) {
+    this[sknative] = `histogram:${bounds.join(",")}`;
+  }
+
+  // Lie to TypeScript that this implements Reducer, but leave out any implementations
+  // since we provide a native implementation.
+  initial!: { bounds: number[]; counts: number[] };
+  add!: (accum: { bounds: number[]; counts: number[] }) => {
+    bounds: number[];
+    counts: number[];
+  };
+  remove!: (accum: {
+    bounds: number[];
+    counts: number[];
+  }) => Nullable<{ bounds: number[]; counts: number[] }>;
+}
@@ -100,6 +100,16 @@ export function registerControlServiceRoutes(
       });
   });
 
+  // DEBUG
+  app.get("/v1/debug/reducers", (_, res) => {
+    try {
+      res.status(200).json(service.getReducerStats());
+    } catch (e: unknown) {
+      console.log(e);
+      res.status(500).json(e instanceof Error ? e.message : e);
+    }
+  });
+
   app.get("/healthz", (_, res) => {
     res.sendStatus(200);
   });
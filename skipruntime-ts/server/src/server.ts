@@ -69,6 +69,12 @@ export type SkipServer = {
  *   Destroys the resource instance identified by `uuid`.
  *   Under normal circumstances, resource instances are deleted automatically after some period of inactivity; this interface enables immediately deleting live streams under exceptional circumstances.
  *
+ * - `GET /v1/debug/reducers`:
+ *   Counters of the reducers of the service's eager collections, for debugging.
+ *
+ *   Responds with a JSON-encoded array of `ReducerStats`, one per eager collection with a reducer: how many updates of a key went through the reducer, and how many of them recomputed the key from all its values.
+ *   The counters of a collection start over whenever it is created again, e.g. when a reload rebuilds the resources graph.
+ *
  * - `GET /healthz`
  *   Check that the Skip service is running normally.
  *   Returns HTTP 200 if the service is healthy, for use in monitoring, deployments, and the like.
@@ -20,8 +20,20 @@ import type {
   Reducer,
   ChangeManager,
 } from "@skipruntime/core";
-import { LoadStatus } from "@skipruntime/core";
-import { Count, Sum } from "@skipruntime/helpers";
+import { LoadStatus, deepFreeze } from "@skipruntime/core";
+import {
+  Count,
+  Explode,
+  Max,
+  Min,
+  Pipeline,
+  Sum,
+  TopK,
+  Variance,
+  type NativeMapperStep,
+  type TopKAccum,
+  type VarianceAccum,
+} from "@skipruntime/helpers";
 
 import { it as mit, type AsyncFunc } from "mocha";
 
@@ -438,6 +450,91 @@ const countService: SkipService<Input_NN, Input_NN> = {
   },
 };
 
+//// testNativeMappers
+
+type Input_Orders = {
+  orders: EagerCollection<number, JsonObject>;
+  users: EagerCollection<string, string>;
+};
+
+class OrdersByUserResource implements Resource<Input_Orders> {
+  instantiate(cs: Input_Orders): EagerCollection<Json, Json> {
+    return cs.orders.map(
+      Pipeline,
+      deepFreeze([
+        { filter: "amount", op: ">=", value: 10 },
+        { keyBy: "user" },
+        { join: 0 },
+      ] as NativeMapperStep[]),
+      cs.users,
+    );
+  }
+}
+
+class OrderItemsResource implements Resource<Input_Orders> {
+  instantiate(cs: Input_Orders): EagerCollection<number, Json> {
+    return cs.orders.map(Explode, "items");
+  }
+}
+
+const nativeMappersService: SkipService<Input_Orders, Input_Orders> = {
+  initialData: { orders: [], users: [] },
+  resources: {
+    ordersByUser: OrdersByUserResource,
+    orderItems: OrderItemsResource,
+  },
+
+  createGraph(inputCollections: Input_Orders) {
+    return inputCollections;
+  },
+};
+
+//// testNativeReducers
+
+class ToZeroMapper implements Mapper<number, number, number, number> {
+  mapEntry(_key: number, values: Values<number>): Iterable<[number, number]> {
+    return values.toArray().map((v) => [0, v]);
+  }
+}
+
+class TopKResource implements Resource<Input_NN> {
+  instantiate(cs: Input_NN): EagerCollection<number, TopKAccum<number>> {
+    return cs.input.mapReduce(ToZeroMapper)(TopK, 1);
+  }
+}
+
+class MinResource implements Resource<Input_NN> {
+  instantiate(cs: Input_NN): EagerCollection<number, number> {
+    return cs.input.mapReduce(ToZeroMapper)(Min);
+  }
+}
+
+class MaxResource implements Resource<Input_NN> {
+  instantiate(cs: Input_NN): EagerCollection<number, number> {
+    return cs.input.mapReduce(ToZeroMapper)(Max);
+  }
+}
+
+class VarianceResource implements Resource<Input_NN> {
+  instantiate(cs: Input_NN): EagerCollection<number, VarianceAccum> {
+    return cs.input.mapReduce(ToZeroMapper)(Variance);
+  }
+}
+
+const nativeReducersService: SkipService<Input_NN, Input_NN> = {
+  initialData: { input: [] },
+  resources: {
+    topk: TopKResource,
+    min: MinResource,
+    max: MaxResource,
+    variance: VarianceResource,
+  },
+
+  createGraph(inputCollections: Input_NN) {
+    return inputCollections;
+  },
+};
+
 //// testMerge1
 
 class Merge1Resource implements Resource<Input_NN_NN> {
@@ -1472,6 +1569,54 @@ export function initTests(
     }
   });
 
+  it("testReducerStats", async () => {
+    const service = await initService(mapReduceService);
+    try {
+      await service.instantiateResource("sums", "mapReduce", {});
+      await service.update("input", [
+        [0, [1]],
+        [1, [1]],
+        [2, [1]],
+      ]);
+      await service.update("input", [
+        [0, [2]],
+        [3, [2]],
+      ]);
+      await service.update("input", [[3, []]]);
+      expect(await service.getAll("mapReduce")).toEqual([
+        [0, [3]],
+        [1, [1]],
+      ]);
+      // Sum is invertible: removing a value never recomputes the key.
+      const stats = service.getReducerStats();
+      expect(stats.length > 0).toEqual(true);
+      expect(stats.some((s) => s.updates > 0)).toEqual(true);
+      expect(stats.every((s) => s.recomputes == 0)).toEqual(true);
+      service.closeResourceInstance("sums");
+    } finally {
+      await service.close();
+    }
+  });
+
+  it("testReducerStatsRecompute", async () => {
+    const service = await initService(nativeReducersService);
+    try {
+      await service.instantiateResource("max", "max", {});
+      await service.update("input", [
+        [1, [10]],
+        [2, [9]],
+      ]);
+      // Removing the maximum goes through all the values again.
+      await service.update("input", [[1, []]]);
+      expect(await service.getAll("max")).toEqual([[0, [9]]]);
+      const stats = service.getReducerStats();
+      expect(stats.some((s) => s.recomputes > 0)).toEqual(true);
+      service.closeResourceInstance("max");
+    } finally {
+      await service.close();
+    }
+  });
+
   it("testCount", async () => {
     const service = await initService(countService);
     try {
@@ -1507,6 +1652,86 @@ export function initTests(
     }
   });
 
+  it("testNativeMappers", async () => {
+    const service = await initService(nativeMappersService);
+    try {
+      await service.update("users", [
+        ["a", ["Alice"]],
+        ["b", ["Bob"]],
+      ]);
+      await service.update("orders", [
+        [1, [{ user: "a", amount: 5, items: ["x"] }]],
+        [2, [{ user: "a", amount: 20, items: ["y", "z"] }]],
+        [3, [{ user: "b", amount: 15, items: [] }]],
+      ]);
+      expect(await service.getAll("ordersByUser")).toEqual([
+        ["a", [[{ user: "a", amount: 20, items: ["y", "z"] }, "Alice"]]],
+        ["b", [[{ user: "b", amount: 15, items: [] }, "Bob"]]],
+      ]);
+      expect(await service.getAll("orderItems")).toEqual([
+        [1, ["x"]],
+        [2, ["y", "z"]],
+      ]);
+      await service.update("users", [["b", ["Robert"]]]);
+      await service.update("orders", [[1, [{ user: "b", amount: 10 }]]]);
+      expect(await service.getAll("ordersByUser")).toEqual([
+        ["a", [[{ user: "a", amount: 20, items: ["y", "z"] }, "Alice"]]],
+        [
+          "b",
+          [
+            [{ user: "b", amount: 10 }, "Robert"],
+            [{ user: "b", amount: 15, items: [] }, "Robert"],
+          ],
+        ],
+      ]);
+      expect(await service.getAll("orderItems")).toEqual([[2, ["y", "z"]]]);
+    } finally {
+      await service.close();
+    }
+  });
+
+  it("testNativeReducers", async () => {
+    const service = await initService(nativeReducersService);
+    try {
+      // Values that are not kept must not get ahead of larger dropped ones.
+      await service.update("input", [[1, [10]]]);
+      await service.update("input", [[2, [9]]]);
+      await service.update("input", [[3, [8]]]);
+      await service.update("input", [[1, []]]);
+      await service.update("input", [[4, [1]]]);
+      await service.update("input", [[2, []]]);
+      expect(await service.getAll("topk")).toEqual([
+        [0, [{ count: 2, spill: [1], top: [8] }]],
+      ]);
+      // Floats are not truncated.
+      await service.update("input", [[5, [0.5]]]);
+      expect(await service.getAll("min")).toEqual([[0, [0.5]]]);
+      await service.update("input", [[6, [8.5]]]);
+      expect(await service.getAll("max")).toEqual([[0, [8.5]]]);
+      await service.update("input", [
+        [3, []],
+        [4, []],
+        [5, []],
+        [6, []],
+      ]);
+      // Large values with a small variance.
+      const offset = 1e9;
+      await service.update(
+        "input",
+        [2, 4, 4, 4, 5, 5, 7, 100].map((v, i) => [10 + i, [offset + v]]),
+      );
+      await service.update("input", [[17, [offset + 9]]]);
+      const entries = await service.getAll("variance");
+      const variance = entries[0]![1][0] as VarianceAccum;
+      expect(variance.count).toEqual(8);
+      expect(Math.abs(variance.mean! - (offset + 5)) < 1e-6).toEqual(true);
+      expect(Math.abs(variance.variance! - 4) < 1e-6).toEqual(true);
+      expect(Math.abs(variance.stddev! - 2) < 1e-6).toEqual(true);
+    } finally {
+      await service.close();
+    }
+  });
+
   it("testMerge1", async () => {
     const service = await initService(merge1Service);
     try {
@@ -57,6 +57,10 @@ export interface FromWasm {
   >(
     ref: Handle<HandlerInfo<Mapper<K1, V1, K2, V2>>>,
   ): ptr<Internal.Mapper>;
+  SkipRuntime_createNativeMapper(
+    mapper: ptr<Internal.String>,
+    collections: ptr<Internal.CJArray<Internal.CJString>>,
+  ): ptr<Internal.Mapper>;
 
   // LazyCompute
 
@@ -169,6 +173,10 @@ export interface FromWasm {
     key: ptr<Internal.CJSON>,
   ): ptr<Internal.CJArray | Internal.CJFloat>;
 
+  SkipRuntime_Runtime__getReducerStats(): ptr<
+    Internal.CJArray | Internal.CJFloat
+  >;
+
   SkipRuntime_Runtime__closeResource(
     identifier: ptr<Internal.String>,
   ): Handle<Error>;
@@ -431,6 +439,16 @@ export class WasmFromBinding implements FromBinding {
     return this.fromWasm.SkipRuntime_createMapper(ref);
   }
 
+  SkipRuntime_createNativeMapper(
+    mapper: string,
+    collections: Pointer<Internal.CJArray<Internal.CJString>>,
+  ): Pointer<Internal.Mapper> {
+    return this.fromWasm.SkipRuntime_createNativeMapper(
+      this.utils.exportString(mapper),
+      toPtr(collections),
+    );
+  }
+
   SkipRuntime_createLazyCompute<K extends Json, V extends Json>(
     ref: Handle<HandlerInfo<LazyCompute<K, V>>>,
   ): Pointer<Internal.LazyCompute> {
@@ -630,6 +648,12 @@ export class WasmFromBinding implements FromBinding {
     );
   }
 
+  SkipRuntime_Runtime__getReducerStats(): Pointer<
+    Internal.CJArray | Internal.CJFloat
+  > {
+    return this.fromWasm.SkipRuntime_Runtime__getReducerStats();
+  }
+
   SkipRuntime_Runtime__closeResource(identifier: string): Handle<Error> {
     return this.fromWasm.SkipRuntime_Runtime__closeResource(
       this.utils.exportString(identifier),
@@ -0,0 +1,61 @@
+#!/bin/bash
+
+if [ -z "$SKDB_BIN" ]; then
+    if [ -z "$SKARGO_PROFILE" ]; then
+        SKARGO_PROFILE=dev
+    fi
+    SKDB_BIN="skargo run -q --profile $SKARGO_PROFILE -- "
+fi
+
+SKDB=$SKDB_BIN
+
+rm -f /tmp/test.db
+
+$SKDB --init /tmp/test.db
+
+echo "create table t1 (a INTEGER, b TEXT);" | $SKDB --data /tmp/test.db
+
+output=$(
+    cat <<'REQUESTS' | $SKDB serve --data /tmp/test.db 2> /dev/null
+{"query": "insert into t1 values (@a, @b);", "params": {"a": 1, "b": "one"}}
+{"query": "insert into t1 values (@a, @b);", "params": {"a": 2, "b": "two"}}
+
+{"query": "select * from t1 where a = @a;", "params": {"a": 2}}
+not json
+{"query": "select * from not_a_table;"}
+{"query": "select count(*) from t1;"}
+REQUESTS
+)
+
+expected=":done
+:done
+2|two
+:done
+:error
+:error
+2
+:done"
+
+if [ "$output" == "$expected" ]; then
+    echo "Serve:      OK"
+else
+    echo "TEST CHECKING THE OUTPUT OF SERVE FAILED"
+    diff <(echo "$expected") <(echo "$output")
+fi
+
+# The memory used by a request is reclaimed: serving ten times more
+# requests must not use much more memory.
+if [ -x /usr/bin/time ]; then
+    requests() {
+        for ((i = 0; i < $1; i++)); do
+            echo '{"query": "select * from t1 where a = @a;", "params": {"a": 1}}'
+        done
+    }
+    rss1=$( { requests 2000 | /usr/bin/time -f "%M" $SKDB serve --data /tmp/test.db > /dev/null; } 2>&1 | tail -n 1)
+    rss2=$( { requests 20000 | /usr/bin/time -f "%M" $SKDB serve --data /tmp/test.db > /dev/null; } 2>&1 | tail -n 1)
+    if (( rss2 > 2 * rss1 )); then
+        echo "TEST CHECKING THE MEMORY OF SERVE FAILED ($rss2 > 2 * $rss1)"
+    else
+        echo "Serve memory: OK ($rss2 <= 2 * $rss1)"
+    fi
+fi
@@ -157,3 +157,11 @@ echo "**************************************************************************
 echo ""
 
 (cd ./test/memory/ && ./run.sh)
+
+echo ""
+echo "*******************************************************************************"
+echo "* SERVE *"
+echo "*******************************************************************************"
+echo ""
+
+(cd ./test/serve/ && ./run.sh)